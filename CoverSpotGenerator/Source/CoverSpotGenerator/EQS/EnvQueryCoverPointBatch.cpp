@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EnvQueryCoverPointBatch.h"
+
+#include "EnvQueryItemType_CoverPoint.h"
+
+void FEnvQueryCoverPointBatch::Gather(const FEnvQueryInstance& QueryInstance, int32 NumContexts)
+{
+	LocationX.Reset(); LocationY.Reset(); LocationZ.Reset();
+	DirX.Reset(); DirY.Reset(); DirZ.Reset();
+	ItemToBatch.Reset(QueryInstance.Items.Num());
+
+	for (const FEnvQueryItem& Item : QueryInstance.Items)
+	{
+		if (!Item.IsValid())
+		{
+			ItemToBatch.Add(INDEX_NONE);
+			continue;
+		}
+
+		const FCoverPointData& cp = UEnvQueryItemType_CoverPoint::GetValue(QueryInstance.RawData.GetData() + Item.DataOffset);
+		ItemToBatch.Add(LocationX.Num());
+		LocationX.Add(cp._location.X); LocationY.Add(cp._location.Y); LocationZ.Add(cp._location.Z);
+		DirX.Add(cp._dirToCover.X); DirY.Add(cp._dirToCover.Y); DirZ.Add(cp._dirToCover.Z);
+	}
+
+	Values.SetNumUninitialized(Num() * NumContexts, false);
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnvironmentQuery/EnvQueryTypes.h"
+
+#include "../Generator/CoverPointKernels.h"
+
+/**
+ * The cover point items of a query, gathered into packed arrays so a cheap geometric test can score all items against all of
+ * its contexts with the vectorized cover point kernels before it iterates the items. Scores are then looked up per item.
+ */
+class COVERSPOTGENERATOR_API FEnvQueryCoverPointBatch
+{
+public:
+	// gathers the items that are still valid, the values of earlier gathers are dropped
+	void Gather(const FEnvQueryInstance& QueryInstance, int32 NumContexts);
+
+	FORCEINLINE int32 Num() const { return LocationX.Num(); }
+	FORCEINLINE FCoverPackedVectors GetLocations() const { return FCoverPackedVectors(LocationX.GetData(), LocationY.GetData(), LocationZ.GetData(), Num()); }
+	FORCEINLINE FCoverPackedVectors GetDirsToCover() const { return FCoverPackedVectors(DirX.GetData(), DirY.GetData(), DirZ.GetData(), Num()); }
+
+	// Num() values per context, for kernels to write to and read from
+	FORCEINLINE float* GetContextValues(int32 ContextIndex) { return Values.GetData() + ContextIndex * Num(); }
+
+	// value of the item for the context, the item must have been valid when gathering
+	FORCEINLINE float GetItemValue(int32 ItemIndex, int32 ContextIndex) const { return Values[ContextIndex * Num() + ItemToBatch[ItemIndex]]; }
+
+private:
+	TArray<float> LocationX, LocationY, LocationZ;
+	TArray<float> DirX, DirY, DirZ;
+	TArray<float> Values;
+	TArray<int32> ItemToBatch;
+};
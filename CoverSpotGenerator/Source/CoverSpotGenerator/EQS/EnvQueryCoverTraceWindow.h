@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnvironmentQuery/EnvQueryTypes.h"
+
+#include "../Generator/CoverWorldRaycaster.h"
+#include "EnvQueryItemType_CoverPoint.h"
+
+/**
+ * The traces of a window of cover point items, executed as one batch that can be spread over worker threads. A test refills the window
+ * whenever its item iterator moves past the end of it, so the query's time slicing still spreads the windows over multiple frames.
+ */
+class FEnvQueryCoverTraceWindow
+{
+public:
+	FORCEINLINE bool NeedsFill(int32 ItemIndex) const { return ItemIndex >= WindowEnd; }
+
+	/**
+	 * Calls AddTraces(CoverPoint, ContextIndex, Traces) for every context of the next NumItems valid items, starting at FirstItem, and executes the
+	 * traces. AddTraces returns the first trace it added or INDEX_NONE if the item needs no traces for that context. With a MaxCountedHits
+	 * above zero the hits of every trace are counted up to that number, otherwise the traces only report their first hit.
+	 */
+	template<typename TFunc>
+	void Fill(UWorld* World, const FEnvQueryInstance& QueryInstance, int32 FirstItem, int32 NumItems, int32 InNumContexts, int32 MaxCountedHits, bool bParallel, TFunc AddTraces)
+	{
+		Traces.Reset();
+		FirstTraces.Reset();
+		NumContexts = InNumContexts;
+		WindowStart = FirstItem;
+		WindowEnd = FirstItem;
+
+		for (int32 NumAdded = 0; WindowEnd < QueryInstance.Items.Num() && NumAdded < NumItems; WindowEnd++)
+		{
+			const FEnvQueryItem& Item = QueryInstance.Items[WindowEnd];
+			if (!Item.IsValid())
+			{
+				FirstTraces.AddUninitialized(NumContexts);
+				continue;
+			}
+
+			const FCoverPointData& cp = UEnvQueryItemType_CoverPoint::GetValue(QueryInstance.RawData.GetData() + Item.DataOffset);
+			for (int32 ContextIndex = 0; ContextIndex < NumContexts; ContextIndex++)
+			{
+				FirstTraces.Add(AddTraces(cp, ContextIndex, Traces));
+			}
+			NumAdded++;
+		}
+
+		FCoverWorldRaycaster Raycaster(World, bParallel);
+		if (MaxCountedHits > 0) Traces.ExecuteCounted(Raycaster, MaxCountedHits);
+		else Traces.Execute(Raycaster);
+	}
+
+	FORCEINLINE int32 GetFirstTrace(int32 ItemIndex, int32 ContextIndex) const { return FirstTraces[(ItemIndex - WindowStart) * NumContexts + ContextIndex]; }
+	FORCEINLINE const FCoverRaycastBatch& GetTraces() const { return Traces; }
+
+private:
+	FCoverRaycastBatch Traces;
+	TArray<int32> FirstTraces; // per item and context
+	int32 NumContexts = 0;
+	int32 WindowStart = 0;
+	int32 WindowEnd = 0;
+};
@@ -39,10 +39,30 @@ void UEnvQueryGenerator_CoverPoints::GenerateItems(FEnvQueryInstance& QueryInsta
 		return;
 	}
 
-	for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
+	const int32 ProfileIndex = cpg->GetAgentProfileIndex(AgentProfile);
+	if (ProfileIndex == INDEX_NONE)
 	{
-		TArray<UCoverPoint*> CoverPoints = cpg->GetCoverPointsWithinExtent(ContextLocations[ContextIndex], BboxExtent.GetValue());
-		QueryInstance.AddItemData<UEnvQueryItemType_CoverPoint>(CoverPoints);
+		UE_LOG(LogTemp, Error, TEXT("EQS cover generator: the generator has no agent profile %s."), *AgentProfile.ToString());
+		return;
+	}
+
+	// query the boxes around all contexts at once, so points near multiple contexts become a single item
+	const float Extent = BboxExtent.GetValue();
+	TArray<FBox, TInlineAllocator<8>> QueryBoxes;
+	for (const FVector& ContextLocation : ContextLocations)
+	{
+		QueryBoxes.Emplace(ContextLocation - FVector(Extent), ContextLocation + FVector(Extent));
+	}
+
+	// generators only run on the game thread, the buffer is reused by all queries
+	static FCoverPointQueryBuffer QueryBuffer;
+	FCoverPointSetPtr CoverPoints = cpg->GetCoverPointsInBoxes(QueryBoxes, QueryBuffer);
+	if (!CoverPoints.IsValid()) return;
+
+	for (int32 Handle : QueryBuffer._handles)
+	{
+		if ((CoverPoints->_store.GetProfiles(Handle) & (1 << ProfileIndex)) == 0) continue;
+		QueryInstance.AddItemData<UEnvQueryItemType_CoverPoint>(CoverPoints->_store.Get(Handle));
 	}
 }
 
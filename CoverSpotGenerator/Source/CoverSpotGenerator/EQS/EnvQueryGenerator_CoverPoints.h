@@ -22,6 +22,10 @@ class COVERSPOTGENERATOR_API UEnvQueryGenerator_CoverPoints : public UEnvQueryGe
 	UPROPERTY(EditDefaultsOnly, Category = "Cover Point Parameters")
 	FAIDataProviderIntValue MaxNumCoverSpots;
 
+	// only generate the cover points of this agent profile of the generator, none for the first profile
+	UPROPERTY(EditDefaultsOnly, Category = "Cover Point Parameters")
+	FName AgentProfile;
+
 	UPROPERTY(EditDefaultsOnly, Category = Generator)
 	TSubclassOf<UEnvQueryContext> GenerateAround;
 
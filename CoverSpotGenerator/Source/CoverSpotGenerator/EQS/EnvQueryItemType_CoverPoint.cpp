@@ -9,23 +9,22 @@
 
 UEnvQueryItemType_CoverPoint::UEnvQueryItemType_CoverPoint(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
-	ValueSize = sizeof(FWeakObjectPtr);
+	ValueSize = sizeof(FCoverPointData);
 }
 
-UCoverPoint* UEnvQueryItemType_CoverPoint::GetValue(const uint8* RawData)
+const FCoverPointData& UEnvQueryItemType_CoverPoint::GetValue(const uint8* RawData)
 {
-	return GetValueFromMemory<UCoverPoint*>(RawData);
+	return GetValueFromMemory<FCoverPointData>(RawData);
 }
 
-void UEnvQueryItemType_CoverPoint::SetValue(uint8* RawData, UCoverPoint* Value)
+void UEnvQueryItemType_CoverPoint::SetValue(uint8* RawData, const FCoverPointData& Value)
 {
-	SetValueInMemory<UCoverPoint*>(RawData, Value);
+	SetValueInMemory<FCoverPointData>(RawData, Value);
 }
 
 FVector UEnvQueryItemType_CoverPoint::GetItemLocation(const uint8* RawData) const
 {
-	UCoverPoint* coverPoint = GetValue(RawData);
-	return coverPoint ? coverPoint->_location : FVector::ZeroVector;
+	return GetValue(RawData)._location;
 }
 
 FString UEnvQueryItemType_CoverPoint::GetDescription(const uint8* RawData) const
@@ -43,10 +42,11 @@ bool UEnvQueryItemType_CoverPoint::StoreInBlackboard(FBlackboardKeySelector& Key
 	// if vector blackboard-key is passed: only get location
 	bool bStored = Super::StoreInBlackboard(KeySelector, Blackboard, RawData);
 
-	// if object blackboard-key is passed: get complete cover point object
+	// if object blackboard-key is passed: wrap the cover point in an object
 	if (!bStored && KeySelector.SelectedKeyType == UBlackboardKeyType_Object::StaticClass())
 	{
-		UObject* CoverObject = GetValue(RawData);
+		UCoverPoint* CoverObject = NewObject<UCoverPoint>(Blackboard);
+		CoverObject->Init(GetValue(RawData));
 		Blackboard->SetValue<UBlackboardKeyType_Object>(KeySelector.GetSelectedKeyID(), CoverObject);
 
 		bStored = true;
@@ -14,10 +14,10 @@ class COVERSPOTGENERATOR_API UEnvQueryItemType_CoverPoint : public UEnvQueryItem
 	GENERATED_UCLASS_BODY()
 	
 public:
-	typedef UCoverPoint* FValueType; // FValueType is used as an abstract type by the EQS system: here we define it
+	typedef FCoverPointData FValueType; // FValueType is used as an abstract type by the EQS system: here we define it
 
-	static UCoverPoint* GetValue(const uint8* RawData);
-	static void SetValue(uint8* RawData, UCoverPoint* Value);
+	static const FCoverPointData& GetValue(const uint8* RawData);
+	static void SetValue(uint8* RawData, const FCoverPointData& Value);
 	
 	virtual FVector GetItemLocation(const uint8* RawData) const;
 
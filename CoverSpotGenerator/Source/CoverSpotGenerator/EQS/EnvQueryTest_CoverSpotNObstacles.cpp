@@ -3,6 +3,7 @@
 #include "EnvQueryTest_CoverSpotNObstacles.h"
 
 #include "EnvQueryItemType_CoverPoint.h"
+#include "EnvQueryCoverTraceWindow.h"
 #include "../Generator/CoverPointGenerator.h"
 
 #include "AISystem.h"
@@ -11,6 +12,9 @@ UEnvQueryTest_CoverSpotNObstacles::UEnvQueryTest_CoverSpotNObstacles(const FObje
 {
 	ValidItemType = UEnvQueryItemType_CoverPoint::StaticClass();
 	ScoringFactor.DefaultValue = -1.0; // by default, prefer less obstacles between querier and target
+	UseVisibilityCache.DefaultValue = false;
+	TraceBatchSize.DefaultValue = 32;
+	ParallelTraces.DefaultValue = true;
 }
 
 void UEnvQueryTest_CoverSpotNObstacles::RunTest(FEnvQueryInstance& QueryInstance) const
@@ -27,6 +31,10 @@ void UEnvQueryTest_CoverSpotNObstacles::RunTest(FEnvQueryInstance& QueryInstance
 	FloatValueMax.BindData(QueryOwner, QueryInstance.QueryID);
 	float MaxFilterThresholdValue = FloatValueMax.GetValue();
 
+	UseVisibilityCache.BindData(QueryOwner, QueryInstance.QueryID);
+	TraceBatchSize.BindData(QueryOwner, QueryInstance.QueryID);
+	ParallelTraces.BindData(QueryOwner, QueryInstance.QueryID);
+
 	TArray<FVector> ContextLocations;
 	if (!QueryInstance.PrepareContext(Context, ContextLocations))
 	{
@@ -41,17 +49,36 @@ void UEnvQueryTest_CoverSpotNObstacles::RunTest(FEnvQueryInstance& QueryInstance
 		return;
 	}
 	
+	const bool bUseVisibilityCache = UseVisibilityCache.GetValue();
+	auto AddTraces = [&](const FCoverPointData& cp, int32 ContextIndex, FCoverRaycastBatch& Traces)
+	{
+		return cpg->AddIntersectionTraces(cp, ContextLocations[ContextIndex], Traces, bUseVisibilityCache);
+	};
+
+	// a pure filter only needs to know whether the maximum is exceeded, so hits are not counted beyond it
+	int32 MaxCountedHits = ACoverPointGenerator::MaxCountedIntersections;
+	if (TestPurpose == EEnvTestPurpose::Filter && (FilterType == EEnvTestFilterType::Maximum || FilterType == EEnvTestFilterType::Range))
+	{
+		MaxCountedHits = FMath::Clamp(FMath::FloorToInt(MaxFilterThresholdValue), 1, MaxCountedHits);
+	}
+
+	// the traces of a window of items run as one batch when the iterator reaches the window, the query may stop between windows
+	FEnvQueryCoverTraceWindow Window;
+	const int32 BatchSize = FMath::Max(TraceBatchSize.GetValue(), 1);
+
 	for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
 	{
-		const UCoverPoint* cp = UEnvQueryItemType_CoverPoint::GetValue(It.GetItemData());
+		if (Window.NeedsFill(It.GetIndex()))
+		{
+			Window.Fill(GetWorld(), QueryInstance, It.GetIndex(), BatchSize, ContextLocations.Num(), MaxCountedHits, ParallelTraces.GetValue(), AddTraces);
+		}
+
+		const FCoverPointData& cp = UEnvQueryItemType_CoverPoint::GetValue(It.GetItemData());
 		
-		if (IsValid(cp))
+		for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
 		{
-			for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
-			{
-				float score = (float)(cpg->GetNumberOfIntersectionsFromCover(cp, ContextLocations[ContextIndex]));
-				It.SetScore(TestPurpose, FilterType, score, MinFilterThresholdValue, MaxFilterThresholdValue);
-			}
+			float score = (float)(cpg->GetNumberOfIntersections(cp, Window.GetTraces(), Window.GetFirstTrace(It.GetIndex(), ContextIndex)));
+			It.SetScore(TestPurpose, FilterType, score, MinFilterThresholdValue, MaxFilterThresholdValue);
 		}
 	}
 }
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "EnvironmentQuery/EnvQueryTest.h"
+#include "DataProviders/AIDataProvider.h"
 
 #include "EnvQueryTest_CoverSpotNObstacles.generated.h"
 
@@ -16,6 +17,18 @@ class COVERSPOTGENERATOR_API UEnvQueryTest_CoverSpotNObstacles : public UEnvQuer
 	UPROPERTY(EditDefaultsOnly, Category = Cover)
 	TSubclassOf<UEnvQueryContext> Context;
 
+	/** count no obstacles where the generator's visibility cache says the context sees the cover point, instead of tracing. Approximate. */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderBoolValue UseVisibilityCache;
+
+	/** number of items whose traces are executed together */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderIntValue TraceBatchSize;
+
+	/** spread the traces of a batch over worker threads */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderBoolValue ParallelTraces;
+
 	virtual void RunTest(FEnvQueryInstance& QueryInstance) const override;
 
 	virtual FText GetDescriptionTitle() const override;
@@ -5,8 +5,8 @@
 #include "../Generator/CoverDataStructures.h"
 #include "../Generator/CoverPointGenerator.h"
 #include "EnvQueryItemType_CoverPoint.h"
+#include "EnvQueryCoverTraceWindow.h"
 
-#include "Kismet/KismetSystemLibrary.h"
 #include "DrawDebugHelpers.h"
 
 UEnvQueryTest_CoverSpot_IsSafe::UEnvQueryTest_CoverSpot_IsSafe(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -19,6 +19,10 @@ UEnvQueryTest_CoverSpot_IsSafe::UEnvQueryTest_CoverSpot_IsSafe(const FObjectInit
 	MyTraceHeight.DefaultValue = 40.0f;
 	EnemyTraceHeight.DefaultValue = 80.0f;
 	TestRadius.DefaultValue = 30.0f;
+	UseVisibilityCache.DefaultValue = false;
+	UseExposureSectors.DefaultValue = false;
+	TraceBatchSize.DefaultValue = 32;
+	ParallelTraces.DefaultValue = true;
 
 	DrawSafeFromAboveTest.DefaultValue = false;
 	DrawSafeFromSideTest.DefaultValue = false;
@@ -35,6 +39,10 @@ void UEnvQueryTest_CoverSpot_IsSafe::RunTest(FEnvQueryInstance& QueryInstance) c
 	EnemyTraceHeight.BindData(QueryOwner, QueryInstance.QueryID);
 	TestRadius.BindData(QueryOwner, QueryInstance.QueryID);
 	MyTraceHeight.BindData(QueryOwner, QueryInstance.QueryID);
+	UseVisibilityCache.BindData(QueryOwner, QueryInstance.QueryID);
+	UseExposureSectors.BindData(QueryOwner, QueryInstance.QueryID);
+	TraceBatchSize.BindData(QueryOwner, QueryInstance.QueryID);
+	ParallelTraces.BindData(QueryOwner, QueryInstance.QueryID);
 	DrawSafeFromAboveTest.BindData(QueryOwner, QueryInstance.QueryID);
 	DrawSafeFromSideTest.BindData(QueryOwner, QueryInstance.QueryID);
 
@@ -54,43 +62,70 @@ void UEnvQueryTest_CoverSpot_IsSafe::RunTest(FEnvQueryInstance& QueryInstance) c
 		return;
 	}
 
-	for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
+	const bool bUseVisibilityCache = UseVisibilityCache.GetValue();
+	const bool bUseExposureSectors = UseExposureSectors.GetValue();
+	const ECoverExposureHeight ExposureHeight = cpg->GetExposureHeight(MyTraceHeight.GetValue());
+	const int32 BatchSize = FMath::Max(TraceBatchSize.GetValue(), 1);
+
+	// the caches only know the static geometry, cells and sectors they are not sure about are traced
+	auto GetVisibility = [&](const FCoverPointData& cp, const AActor* Context)
+	{
+		ECoverVisibility Visibility = bUseVisibilityCache ? cpg->GetCachedVisibility(cp, Context->GetActorLocation()) : ECoverVisibility::Unknown;
+		if (bUseExposureSectors && (Visibility == ECoverVisibility::Unknown || Visibility == ECoverVisibility::Mixed))
+		{
+			Visibility = cpg->GetCachedExposure(cp, Context->GetActorLocation(), ExposureHeight);
+		}
+		return Visibility;
+	};
+
+	auto AddTraces = [&](const FCoverPointData& cp, int32 ContextIndex, FCoverRaycastBatch& Traces)
 	{
-		const UCoverPoint* cp = UEnvQueryItemType_CoverPoint::GetValue(It.GetItemData());
+		ECoverVisibility Visibility = GetVisibility(cp, ContextActors[ContextIndex]);
+		if (Visibility == ECoverVisibility::Hidden || Visibility == ECoverVisibility::Visible) return (int32)INDEX_NONE;
 
-		if (!IsValid(cp))
+		return AddSafetyTraces(world, ContextActors[ContextIndex], cp, Traces);
+	};
+
+	// the traces of a window of items run as one batch when the iterator reaches the window, the query may stop between windows
+	FEnvQueryCoverTraceWindow Window;
+
+	for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
+	{
+		if (Window.NeedsFill(It.GetIndex()))
 		{
-			UE_LOG(LogTemp, Warning, TEXT("invalid cover point"));
-			continue;
+			Window.Fill(world, QueryInstance, It.GetIndex(), BatchSize, ContextActors.Num(), 0, ParallelTraces.GetValue(), AddTraces);
 		}
 
+		const FCoverPointData& cp = UEnvQueryItemType_CoverPoint::GetValue(It.GetItemData());
+
 		for (int32 ContextIndex = 0; ContextIndex < ContextActors.Num(); ContextIndex++)
 		{
-			bool isSafe = CoverProvidesSafety(world, ContextActors[ContextIndex], cp, cpg);
+			const AActor* Context = ContextActors[ContextIndex];
+			int32 FirstTrace = Window.GetFirstTrace(It.GetIndex(), ContextIndex);
+
+			bool isSafe = FirstTrace != INDEX_NONE ? CoverProvidesSafety(Context, cp, Window.GetTraces(), FirstTrace) : GetVisibility(cp, Context) == ECoverVisibility::Hidden;
 			It.SetScore(TestPurpose, FilterType, isSafe, true);
 		}
 	}
 }
 
-bool UEnvQueryTest_CoverSpot_IsSafe::CoverProvidesSafety(UWorld* world, const AActor* context, const UCoverPoint* coverPoint, const ACoverPointGenerator* cpg) const
-{	
+int32 UEnvQueryTest_CoverSpot_IsSafe::AddSafetyTraces(UWorld* world, const AActor* context, const FCoverPointData& coverPoint, FCoverRaycastBatch& traces) const
+{
 	// check outer point that may be visible from side
-	FVector sideOffset = coverPoint->_leanDirection;
+	FVector sideOffset = coverPoint._leanDirection;
 	sideOffset.Z = 0.0f;
-	FVector backOffset = -1.0f * coverPoint->_dirToCover;
+	FVector backOffset = -1.0f * coverPoint._dirToCover;
 	backOffset.Z = 0.0f;
 
 	FVector outerBodyPointDir = sideOffset + backOffset;
 	outerBodyPointDir.Normalize();
 
-	FVector traceStart = coverPoint->_location + outerBodyPointDir * TestRadius.GetValue();
+	FVector traceStart = coverPoint._location + outerBodyPointDir * TestRadius.GetValue();
 	traceStart.Z += MyTraceHeight.GetValue();
 	FVector traceEnd = context->GetActorLocation();
 	traceEnd.Z += EnemyTraceHeight.GetValue();
-	FHitResult outHit2;
-	UKismetSystemLibrary::LineTraceSingle(world, traceStart, traceEnd, ETraceTypeQuery::TraceTypeQuery1, false, TArray<AActor*>(), EDrawDebugTrace::None, outHit2, true);
-	bool isSafeFromSide = outHit2.bBlockingHit ? (outHit2.Actor != context) : false;
-	
+	int32 firstTrace = traces.Add(traceStart, traceEnd);
+
 	if (DrawSafeFromSideTest.GetValue())
 	{
 		DrawDebugLine(world, traceStart, traceEnd, FColor::Green, false, 1.0f);
@@ -98,18 +133,14 @@ bool UEnvQueryTest_CoverSpot_IsSafe::CoverProvidesSafety(UWorld* world, const AA
 	}
 
 	// check if the enemy can attack agent from above at this cover position
-	bool isSafeFromAbove = true;
-	if (coverPoint->_leanDirection.Z > 0.0f)
+	if (coverPoint._leanDirection.Z > 0.0f)
 	{
 		// check from center 
-		FVector traceStart = coverPoint->_location + -1.0f * coverPoint->_dirToCover * TestRadius.GetValue();
+		FVector traceStart = coverPoint._location + -1.0f * coverPoint._dirToCover * TestRadius.GetValue();
 		traceStart.Z += MyTraceHeight.GetValue();
 		FVector traceEnd = context->GetActorLocation();
 		traceEnd.Z += EnemyTraceHeight.GetValue();
-		
-		FHitResult outHit;
-		UKismetSystemLibrary::LineTraceSingle(world, traceStart, traceEnd, ETraceTypeQuery::TraceTypeQuery1, false, TArray<AActor*>(), EDrawDebugTrace::None, outHit, true);
-		isSafeFromAbove = outHit.bBlockingHit ? (outHit.Actor != context) : false;
+		traces.Add(traceStart, traceEnd);
 
 		if (DrawSafeFromAboveTest.GetValue())
 		{
@@ -118,6 +149,22 @@ bool UEnvQueryTest_CoverSpot_IsSafe::CoverProvidesSafety(UWorld* world, const AA
 		}
 	}
 
+	return firstTrace;
+}
+
+bool UEnvQueryTest_CoverSpot_IsSafe::CoverProvidesSafety(const AActor* context, const FCoverPointData& coverPoint, const FCoverRaycastBatch& traces, int32 firstTrace) const
+{
+	// the cover is safe if something other than the enemy blocks the traces
+	const FCoverRaycastHit& sideHit = traces.GetHit(firstTrace);
+	bool isSafeFromSide = sideHit._blockingHit ? (sideHit._actor != context) : false;
+
+	bool isSafeFromAbove = true;
+	if (coverPoint._leanDirection.Z > 0.0f)
+	{
+		const FCoverRaycastHit& aboveHit = traces.GetHit(firstTrace + 1);
+		isSafeFromAbove = aboveHit._blockingHit ? (aboveHit._actor != context) : false;
+	}
+
 	return (isSafeFromSide && isSafeFromAbove);
 }
 
@@ -8,8 +8,9 @@
 
 #include "EnvQueryTest_CoverSpot_IsSafe.generated.h"
 
-class UCoverPoint;
+struct FCoverPointData;
 class ACoverPointGenerator;
+class FCoverRaycastBatch;
 
 UCLASS()
 class COVERSPOTGENERATOR_API UEnvQueryTest_CoverSpot_IsSafe : public UEnvQueryTest
@@ -29,6 +30,25 @@ class COVERSPOTGENERATOR_API UEnvQueryTest_CoverSpot_IsSafe : public UEnvQueryTe
 	UPROPERTY(EditDefaultsOnly, Category = Cover)
 	FAIDataProviderFloatValue TestRadius;
 
+	/** answer from the generator's visibility cache where it is conclusive, traces are only done for the remaining items. The cache samples
+	 *  whole cells and ignores the trace heights and the test radius, so the answers are approximate. Off by default. */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderBoolValue UseVisibilityCache;
+
+	/** answer from the generator's exposure sectors by the threat's bearing where the visibility cache is not conclusive. The sectors are
+	 *  measured from the cover point itself at the generator's crouch or stand attack height, whichever is closer to MyTraceHeight, and
+	 *  are quantized to 16 directions. The answers are approximate, off by default. */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderBoolValue UseExposureSectors;
+
+	/** number of items whose traces are executed together */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderIntValue TraceBatchSize;
+
+	/** spread the traces of a batch over worker threads */
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	FAIDataProviderBoolValue ParallelTraces;
+
 	UPROPERTY(EditDefaultsOnly, Category = Debug)
 	FAIDataProviderBoolValue DrawSafeFromAboveTest;
 
@@ -41,5 +61,7 @@ class COVERSPOTGENERATOR_API UEnvQueryTest_CoverSpot_IsSafe : public UEnvQueryTe
 	virtual FText GetDescriptionDetails() const override;
 
 protected:
-	bool CoverProvidesSafety(UWorld* world, const AActor* context, const UCoverPoint* coverPoint, const ACoverPointGenerator* cpg) const;
+	// adds the side trace and, if the agent can lean over the cover, the above trace. Returns the first of them.
+	int32 AddSafetyTraces(UWorld* world, const AActor* context, const FCoverPointData& coverPoint, FCoverRaycastBatch& traces) const;
+	bool CoverProvidesSafety(const AActor* context, const FCoverPointData& coverPoint, const FCoverRaycastBatch& traces, int32 firstTrace) const;
 };
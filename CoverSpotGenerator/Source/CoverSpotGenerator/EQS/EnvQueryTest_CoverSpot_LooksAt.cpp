@@ -5,6 +5,7 @@
 #include "../Generator/CoverDataStructures.h"
 #include "../Generator/CoverPointGenerator.h"
 #include "EnvQueryItemType_CoverPoint.h"
+#include "EnvQueryCoverPointBatch.h"
 
 UEnvQueryTest_CoverSpot_LooksAt::UEnvQueryTest_CoverSpot_LooksAt(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -44,34 +45,33 @@ void UEnvQueryTest_CoverSpot_LooksAt::RunTest(FEnvQueryInstance& QueryInstance)
 		return;
 	}
 
+	// the scores of all items are computed up front, the iterator only hands them out (and may still be time sliced)
+	static FEnvQueryCoverPointBatch Batch;
+	Batch.Gather(QueryInstance, ContextLocations.Num());
+	ScoreViewingAngles(Batch, ContextLocations);
+
 	for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
 	{
-		const UCoverPoint* cp = UEnvQueryItemType_CoverPoint::GetValue(It.GetItemData());
-
-		if (IsValid(cp))
+		for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
 		{
-			for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
-			{
-				It.SetScore(TestPurpose, FilterType, ScoreViewingAngle(cp, ContextLocations[ContextIndex]), FloatValueMin.GetValue(), FloatValueMax.GetValue());
-			}
+			It.SetScore(TestPurpose, FilterType, Batch.GetItemValue(It.GetIndex(), ContextIndex), FloatValueMin.GetValue(), FloatValueMax.GetValue());
 		}
 	}
 }
 
-float UEnvQueryTest_CoverSpot_LooksAt::ScoreViewingAngle(const UCoverPoint* cp, const FVector& targetLocation) const
+void UEnvQueryTest_CoverSpot_LooksAt::ScoreViewingAngles(FEnvQueryCoverPointBatch& Batch, const TArray<FVector>& ContextLocations) const
 {
-	// calculate viewing angle, which is the angle between the cover point view direction and the target location
-	FVector dirToTarget = targetLocation - cp->_location;
-	dirToTarget.Normalize();
-	float angle = FMath::Acos(FVector::DotProduct(cp->_dirToCover, dirToTarget));
-	angle = FMath::RadiansToDegrees(angle);
-	angle -= MaxScoreViewingAngle.GetValue();
-	
-	// scale the value such that it fits within the min- and max score viewing angle parameters
-	float viewRange = MinScoreViewingAngle.GetValue() - MaxScoreViewingAngle.GetValue();
-	angle = FMath::Clamp((angle / viewRange), 0.0f, 1.0f);
+	// The viewing angle is the angle between the cover point view direction and the target location. It is compared in cosine space,
+	// so the score goes linearly from 0 at the max score angle to 1 at the min score angle in the cosine of the angle instead of the angle.
+	const float MaxScoreCos = FMath::Cos(FMath::DegreesToRadians(MaxScoreViewingAngle.GetValue()));
+	const float MinScoreCos = FMath::Cos(FMath::DegreesToRadians(MinScoreViewingAngle.GetValue()));
 
-	return angle;
+	for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
+	{
+		float* Scores = Batch.GetContextValues(ContextIndex);
+		CoverPointKernels::CosAngleToTarget(Batch.GetLocations(), Batch.GetDirsToCover(), ContextLocations[ContextIndex], Scores);
+		CoverPointKernels::LinearStep(Scores, Batch.Num(), MaxScoreCos, MinScoreCos, Scores);
+	}
 }
 
 FText UEnvQueryTest_CoverSpot_LooksAt::GetDescriptionTitle() const
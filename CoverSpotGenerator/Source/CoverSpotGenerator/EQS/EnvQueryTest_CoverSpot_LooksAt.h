@@ -8,7 +8,7 @@
 
 #include "EnvQueryTest_CoverSpot_LooksAt.generated.h"
 
-class UCoverPoint;
+class FEnvQueryCoverPointBatch;
 
 UCLASS()
 class COVERSPOTGENERATOR_API UEnvQueryTest_CoverSpot_LooksAt : public UEnvQueryTest
@@ -37,5 +37,6 @@ class COVERSPOTGENERATOR_API UEnvQueryTest_CoverSpot_LooksAt : public UEnvQueryT
 	virtual FText GetDescriptionDetails() const override;
 
 protected:
-	float ScoreViewingAngle(const UCoverPoint* cp, const FVector& targetLocation) const;
+	// scores all gathered items against all contexts in one vectorized pass
+	void ScoreViewingAngles(FEnvQueryCoverPointBatch& Batch, const TArray<FVector>& ContextLocations) const;
 };
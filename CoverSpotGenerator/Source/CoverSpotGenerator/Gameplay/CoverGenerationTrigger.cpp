@@ -47,7 +47,14 @@ void ACoverGenerationTrigger::OnGenerateCoverPoints(UPrimitiveComponent* Overlap
 	ACoverPointGenerator* cpg = ACoverPointGenerator::Get(world);
 	if (IsValid(cpg))
 	{
-		cpg->UpdateCoverpointData(bbox);
+		if (keepExistingCoverPoints)
+		{
+			cpg->UpdateCoverpointDataInRegion(bbox);
+		}
+		else
+		{
+			cpg->UpdateCoverpointData(bbox);
+		}
 	}
 }
 
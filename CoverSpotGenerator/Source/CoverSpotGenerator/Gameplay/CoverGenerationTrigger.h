@@ -22,6 +22,10 @@ public:
 	UPROPERTY(EditAnywhere)
 	UBoxComponent* generationBox;
 
+	// only regenerate the cover points inside the generation box instead of resetting all cover point data
+	UPROPERTY(EditAnywhere)
+	bool keepExistingCoverPoints = false;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverBakeData.h"
+
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+FString CoverBakeData::GetBakeFilePath(const FString& levelPackageName)
+{
+	return FPaths::ProjectContentDir() / TEXT("CoverData") / FPackageName::GetShortName(levelPackageName) + TEXT(".cvrbake");
+}
+
+bool CoverBakeData::Save(const FString& path, FCoverBakeHeader& header, FCoverPointSet& coverPoints)
+{
+	TArray<uint8> fileData;
+	FMemoryWriter writer(fileData);
+	writer << header;
+	coverPoints._store.Serialize(writer);
+	coverPoints._visibility.Serialize(writer);
+	coverPoints._exposure.Serialize(writer);
+
+	return FFileHelper::SaveArrayToFile(fileData, *path);
+}
+
+bool CoverBakeData::LoadHeader(const TArray<uint8>& fileData, FCoverBakeHeader& outHeader)
+{
+	FMemoryReader reader(fileData);
+	reader << outHeader;
+
+	return !reader.IsError() && outHeader._magic == FCoverBakeHeader::Magic && outHeader._version == FCoverBakeHeader::Version;
+}
+
+bool CoverBakeData::LoadPoints(const TArray<uint8>& fileData, FCoverPointSet& outCoverPoints)
+{
+	FMemoryReader reader(fileData);
+	FCoverBakeHeader header;
+	reader << header;
+	outCoverPoints._store.Serialize(reader);
+	outCoverPoints._visibility.Serialize(reader);
+	outCoverPoints._exposure.Serialize(reader);
+
+	return !reader.IsError();
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverGenerationJob.h"
+
+// Header of a baked cover data file. The hashes detect bakes that no longer match the level's navmesh or the generator's parameters.
+struct FCoverBakeHeader
+{
+	static const uint32 Magic = 0x42525643; // "CVRB"
+	static const uint32 Version = 5; // 2: visibility cache, 3: obstacle heights, 4: agent profiles, 5: exposure sectors
+
+	uint32 _magic = Magic;
+	uint32 _version = Version;
+	uint32 _navMeshHash = 0;
+	uint32 _parameterHash = 0;
+	FBox _bounds = FBox(ForceInit); // generation bbox of the bake
+	ECoverPointIndexType _indexType = ECoverPointIndexType::Octree;
+
+	friend FArchive& operator<<(FArchive& ar, FCoverBakeHeader& header)
+	{
+		ar << header._magic << header._version << header._navMeshHash << header._parameterHash << header._bounds << header._indexType;
+		return ar;
+	}
+};
+
+/**
+ * Reads and writes baked cover data: the header followed by the cover point store and its visibility cache. The spatial index
+ * is not written, it is rebuilt from the points when loading (no line traces are needed for that).
+ */
+namespace CoverBakeData
+{
+	// file of the bake that belongs to the given level package, e.g. Content/CoverData/MyMap.cvrbake
+	COVERSPOTGENERATOR_API FString GetBakeFilePath(const FString& levelPackageName);
+
+	COVERSPOTGENERATOR_API bool Save(const FString& path, FCoverBakeHeader& header, FCoverPointSet& coverPoints);
+
+	// only reads the header, so a stale bake can be rejected without loading its points
+	COVERSPOTGENERATOR_API bool LoadHeader(const TArray<uint8>& fileData, FCoverBakeHeader& outHeader);
+	COVERSPOTGENERATOR_API bool LoadPoints(const TArray<uint8>& fileData, FCoverPointSet& outCoverPoints);
+}
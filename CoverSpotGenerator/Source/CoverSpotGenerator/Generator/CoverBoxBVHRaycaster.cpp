@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverBoxBVHRaycaster.h"
+
+#include "Algo/Sort.h"
+
+// Slab test of the segment start + t * delta, t in [0, 1]. Returns the entry t and the normal of the face that is entered.
+// A segment that starts inside the box does not hit it, like line traces do not hit the inside of a shape.
+static bool IntersectBox(const FBox& box, const FVector& start, const FVector& delta, float maxT, float& outT, FVector& outNormal)
+{
+	float entryT = 0.0f;
+	float exitT = maxT;
+	int32 entryAxis = INDEX_NONE;
+	float entrySign = 0.0f;
+
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		if (FMath::IsNearlyZero(delta[axis]))
+		{
+			if (start[axis] < box.Min[axis] || start[axis] > box.Max[axis]) return false;
+			continue;
+		}
+
+		float invDelta = 1.0f / delta[axis];
+		float nearT = (box.Min[axis] - start[axis]) * invDelta;
+		float farT = (box.Max[axis] - start[axis]) * invDelta;
+		float sign = -1.0f;
+		if (nearT > farT)
+		{
+			Swap(nearT, farT);
+			sign = 1.0f;
+		}
+
+		if (nearT > entryT)
+		{
+			entryT = nearT;
+			entryAxis = axis;
+			entrySign = sign;
+		}
+		exitT = FMath::Min(exitT, farT);
+		if (entryT > exitT) return false;
+	}
+
+	if (entryAxis == INDEX_NONE) return false;
+
+	outT = entryT;
+	outNormal = FVector::ZeroVector;
+	outNormal[entryAxis] = entrySign;
+	return true;
+}
+
+void FCoverBoxBVHRaycaster::AddBox(const FBox& box)
+{
+	_boxes.Add(box);
+}
+
+void FCoverBoxBVHRaycaster::Build()
+{
+	_nodes.Reset();
+	if (_boxes.Num() > 0)
+	{
+		BuildNode(0, _boxes.Num());
+	}
+}
+
+int32 FCoverBoxBVHRaycaster::BuildNode(int32 firstBox, int32 numBoxes)
+{
+	int32 nodeIdx = _nodes.AddUninitialized();
+	FBox bounds(ForceInit);
+	FBox centerBounds(ForceInit);
+	for (int32 boxIdx = firstBox; boxIdx < firstBox + numBoxes; boxIdx++)
+	{
+		bounds += _boxes[boxIdx];
+		centerBounds += _boxes[boxIdx].GetCenter();
+	}
+
+	if (numBoxes <= MaxBoxesPerLeaf)
+	{
+		_nodes[nodeIdx] = { bounds, firstBox, numBoxes, INDEX_NONE };
+		return nodeIdx;
+	}
+
+	// split at the median of the longest axis of the box centers
+	FVector centerSize = centerBounds.GetSize();
+	int32 axis = centerSize.X > centerSize.Y ? (centerSize.X > centerSize.Z ? 0 : 2) : (centerSize.Y > centerSize.Z ? 1 : 2);
+	int32 numFirst = numBoxes / 2;
+	TArrayView<FBox> boxes(_boxes.GetData() + firstBox, numBoxes);
+	Algo::Sort(boxes, [axis](const FBox& a, const FBox& b) { return a.GetCenter()[axis] < b.GetCenter()[axis]; });
+
+	BuildNode(firstBox, numFirst);
+	int32 secondChild = BuildNode(firstBox + numFirst, numBoxes - numFirst);
+	_nodes[nodeIdx] = { bounds, firstBox, 0, secondChild };
+
+	return nodeIdx;
+}
+
+void FCoverBoxBVHRaycaster::Raycast(const TArray<FVector>& starts, const TArray<FVector>& ends, TArray<FCoverRaycastHit>& outHits)
+{
+	for (int32 traceIdx = 0; traceIdx < starts.Num(); traceIdx++)
+	{
+		Raycast(starts[traceIdx], ends[traceIdx], outHits[traceIdx]);
+	}
+}
+
+bool FCoverBoxBVHRaycaster::Raycast(const FVector& start, const FVector& end, FCoverRaycastHit& outHit) const
+{
+	outHit = FCoverRaycastHit();
+	if (_nodes.Num() == 0) return false;
+
+	const FVector delta = end - start;
+	float closestT = 1.0f;
+	FVector normal;
+
+	// depth first, nodes that start behind the closest hit so far are skipped
+	TArray<int32, TInlineAllocator<64>> stack;
+	stack.Push(0);
+	while (stack.Num() > 0)
+	{
+		const FNode& node = _nodes[stack.Pop(false)];
+
+		float nodeT;
+		FVector nodeNormal;
+		if (!node._bounds.IsInside(start) && !IntersectBox(node._bounds, start, delta, closestT, nodeT, nodeNormal)) continue;
+
+		if (node._numBoxes == 0)
+		{
+			stack.Push(node._secondChild);
+			stack.Push(&node - _nodes.GetData() + 1);
+			continue;
+		}
+
+		for (int32 boxIdx = node._firstBox; boxIdx < node._firstBox + node._numBoxes; boxIdx++)
+		{
+			float hitT;
+			if (IntersectBox(_boxes[boxIdx], start, delta, closestT, hitT, normal) && hitT <= closestT)
+			{
+				closestT = hitT;
+				outHit._blockingHit = true;
+				outHit._normal = normal;
+				outHit._impactNormal = normal;
+			}
+		}
+	}
+
+	if (outHit._blockingHit)
+	{
+		outHit._location = start + delta * closestT;
+		outHit._distance = delta.Size() * closestT;
+	}
+
+	return outHit._blockingHit;
+}
+
+void FCoverBoxBVHRaycaster::CountHits(const TArray<FVector>& starts, const TArray<FVector>& ends, int32 maxCount, TArray<int32>& outNumHits)
+{
+	for (int32 traceIdx = 0; traceIdx < starts.Num(); traceIdx++)
+	{
+		outNumHits[traceIdx] = CountHits(starts[traceIdx], ends[traceIdx], maxCount);
+	}
+}
+
+int32 FCoverBoxBVHRaycaster::CountHits(const FVector& start, const FVector& end, int32 maxCount) const
+{
+	// segments that start inside a box do not hit it, so every next raycast starts just inside the box that was hit
+	const float stepInDistance = 0.1f;
+	const FVector traceDir = (end - start).GetSafeNormal();
+
+	FVector traceStart = start;
+	int32 numHits = 0;
+	FCoverRaycastHit hit;
+	while (numHits <= maxCount && Raycast(traceStart, end, hit))
+	{
+		numHits++;
+		traceStart = hit._location + traceDir * stepInDistance;
+		if (FVector::DotProduct(end - traceStart, traceDir) <= 0.0f) break;
+	}
+
+	return numHits;
+}
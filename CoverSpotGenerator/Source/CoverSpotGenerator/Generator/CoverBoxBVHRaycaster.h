@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverRaycaster.h"
+
+/**
+ * Raycaster over a set of axis aligned boxes, kept in a bounding volume hierarchy. Needs no world, so the generation can run
+ * and be profiled in standalone programs and offline tools on simple box geometry.
+ */
+class COVERSPOTGENERATOR_API FCoverBoxBVHRaycaster : public ICoverRaycaster
+{
+public:
+	void AddBox(const FBox& box);
+
+	// (re)builds the hierarchy, needed after adding boxes
+	void Build();
+
+	virtual void Raycast(const TArray<FVector>& starts, const TArray<FVector>& ends, TArray<FCoverRaycastHit>& outHits) override;
+	bool Raycast(const FVector& start, const FVector& end, FCoverRaycastHit& outHit) const;
+	virtual void CountHits(const TArray<FVector>& starts, const TArray<FVector>& ends, int32 maxCount, TArray<int32>& outNumHits) override;
+	int32 CountHits(const FVector& start, const FVector& end, int32 maxCount) const;
+
+	FORCEINLINE int32 NumBoxes() const { return _boxes.Num(); }
+
+private:
+	// leaves refer to a range of _boxes, inner nodes store their second child, the first child follows the node directly
+	struct FNode
+	{
+		FBox _bounds;
+		int32 _firstBox;
+		int32 _numBoxes; // 0 for inner nodes
+		int32 _secondChild;
+	};
+
+	static const int32 MaxBoxesPerLeaf = 4;
+
+	int32 BuildNode(int32 firstBox, int32 numBoxes);
+
+	TArray<FBox> _boxes;
+	TArray<FNode> _nodes;
+};
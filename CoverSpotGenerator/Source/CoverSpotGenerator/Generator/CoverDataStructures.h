@@ -7,6 +7,107 @@
 
 #include "CoverDataStructures.generated.h"
 
+// how an agent can use a cover point
+enum class ECoverPointFlags : uint8
+{
+	None = 0,
+	CanStand = 1 << 0,
+	CanLeanOver = 1 << 1,
+	CanLeanSide = 1 << 2
+};
+ENUM_CLASS_FLAGS(ECoverPointFlags);
+
+// how the generation searches the sides of an obstacle along a nav mesh edge
+UENUM()
+enum class ECoverSideSearchMode : uint8
+{
+	Linear, // steps of the obstacle side check interval, up to the number of obstacle side checks
+	Adaptive // doubles the step until the side is passed, then bisects down to the side search tolerance
+};
+
+// agent profiles are stored as bit masks, bit i is the generator's profile i
+static const int32 MaxCoverAgentProfiles = 8;
+static const uint8 AllCoverAgentProfiles = 0xFF;
+
+// An agent type the generator creates cover points for. Its nav mesh decides where points are searched, its thresholds
+// how the agent can use the obstacles found.
+USTRUCT(BlueprintType)
+struct FCoverAgentProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cover Agent Profile")
+		FName _name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cover Agent Profile")
+		float _agentRadius = 34.0f; // together with the height, selects the navigation data of the agent
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cover Agent Profile")
+		float _agentHeight = 144.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cover Agent Profile")
+		float _minCrouchCoverHeight = 120.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cover Agent Profile")
+		float _minStandCoverHeight = 180.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cover Agent Profile")
+		float _maxAttackOverEdgeHeight = 140.0f;
+};
+
+// A single generated cover point. The generator keeps its points in an FCoverPointStore, a point is addressed by its handle.
+USTRUCT(BlueprintType)
+struct FCoverPointData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		FVector _location;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		FVector _dirToCover;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		FVector _leanDirection;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		uint8 _flags; // ECoverPointFlags
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		float _obstacleHeight; // height of the obstacle in front of the cover point, capped above the highest height test
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		uint8 _profiles; // agent profiles that can use the point in this way
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cover Point")
+		int32 _handle;
+
+	FCoverPointData() : _location(FVector::ZeroVector), _dirToCover(FVector::ZeroVector), _leanDirection(FVector::ZeroVector), _flags(0), _obstacleHeight(0.0f), _profiles(0), _handle(INDEX_NONE) { }
+
+	FORCEINLINE void Init(const FVector& location, const FVector& dirToCover, const FVector& leanDir, bool canStand, float obstacleHeight, uint8 profiles)
+	{
+		const float epsilon = 0.0001f;
+
+		_location = location;
+		_dirToCover = dirToCover;
+		_leanDirection = leanDir;
+		_obstacleHeight = obstacleHeight;
+		_profiles = profiles;
+
+		ECoverPointFlags flags = canStand ? ECoverPointFlags::CanStand : ECoverPointFlags::None;
+		if (leanDir.Z > epsilon) flags |= ECoverPointFlags::CanLeanOver;
+		if (FVector2D(leanDir).SizeSquared() > epsilon) flags |= ECoverPointFlags::CanLeanSide;
+		_flags = (uint8)flags;
+	}
+
+	FORCEINLINE bool HasFlag(ECoverPointFlags flag) const { return (_flags & (uint8)flag) != 0; }
+	FORCEINLINE bool CanStand() const { return HasFlag(ECoverPointFlags::CanStand); }
+	FORCEINLINE bool CanLeanOver() const { return HasFlag(ECoverPointFlags::CanLeanOver); }
+	FORCEINLINE bool CanLeanSide() const { return HasFlag(ECoverPointFlags::CanLeanSide); }
+	FORCEINLINE bool HasProfile(int32 profileIdx) const { return (_profiles & (1 << profileIdx)) != 0; }
+};
+
+// Blueprint wrapper of a cover point, only created when a cover point is handed to gameplay (e.g. stored in a blackboard).
 UCLASS(BlueprintType, Blueprintable)
 class UCoverPoint : public UObject
 {
@@ -25,32 +126,143 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Cover Point")
 		bool _canStand;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Cover Point")
+		float _obstacleHeight;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Cover Point")
+		uint8 _profiles;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Cover Point")
+		int32 _handle;
+
 	UCoverPoint() = default;
 	~UCoverPoint() { }
 
-	FORCEINLINE void Init(FVector location, FVector dirToCover, FVector leanDir, bool canStand)
+	FORCEINLINE void Init(const FCoverPointData& data)
 	{
-		_location = location;
-		_dirToCover = dirToCover;
-		_leanDirection = leanDir;
-		_canStand = canStand;
+		_location = data._location;
+		_dirToCover = data._dirToCover;
+		_leanDirection = data._leanDirection;
+		_canStand = data.CanStand();
+		_obstacleHeight = data._obstacleHeight;
+		_profiles = data._profiles;
+		_handle = data._handle;
+	}
+};
+
+// nav mesh edge, referring to two vertices in the generator's (ground projected) vertex table
+struct FCoverNavEdge
+{
+	FCoverNavEdge(int32 v1, int32 v2, uint8 profiles) : _v1(v1), _v2(v2), _profiles(profiles) { }
+
+	int32 _v1;
+	int32 _v2;
+	uint8 _profiles; // agent profiles whose nav mesh has this edge
+};
+
+// cover point produced by the generation loop that has not been stored in the octree yet
+struct FCoverPointCandidate
+{
+	FCoverPointCandidate(const FVector& location, const FVector& dirToCover, const FVector& leanDir, bool canStand, float obstacleHeight, uint8 profiles)
+		: _location(location), _dirToCover(dirToCover), _leanDirection(leanDir), _canStand(canStand), _obstacleHeight(obstacleHeight), _profiles(profiles) { }
+
+	FVector _location;
+	FVector _dirToCover;
+	FVector _leanDirection;
+	bool _canStand;
+	float _obstacleHeight;
+	uint8 _profiles;
+};
+
+// state of the sweep along an obstacle that searches for the side of the obstacle, starting at a nav mesh vertex
+struct FCoverSideSearch
+{
+	FVector _startPoint; // nav mesh vertex raised to the sweep height
+	FVector _leanDirection;
+	FVector _sweepDirection;
+	float _sweepHeight = 0.0f;
+	float _clearOffset = 0.0f; // furthest offset along the sweep at which the trace still gives the start result
+	float _lastDistance = 0.0f; // trace distance at the clear offset
+	float _changedOffset = -1.0f; // nearest offset at which the trace result changed, negative while the side was not passed
+	float _changedDistance = 0.0f;
+	float _probeOffset = 0.0f;
+	bool _sweepInLeanDir = false;
+	bool _searching = false;
+	bool _foundEndPoint = false;
+	bool _isValid = false; // a valid side cover point was found
+	FVector _sidePoint;
+	int32 _pointIdx = INDEX_NONE; // index of the resulting cover point in the edge's point list
+	int32 _traceIdx = INDEX_NONE;
+	float _obstacleHeight = 0.0f;
+
+	FORCEINLINE void Init(const FVector& navVert, const FVector& leanDirection, const FVector& edgeDir, float sweepHeight)
+	{
+		_startPoint = navVert;
+		_startPoint.Z += sweepHeight;
+		_leanDirection = leanDirection;
+		_sweepDirection = edgeDir;
+		_sweepHeight = sweepHeight;
 	}
 };
 
+// working data of a single nav mesh edge while it passes through the generation stages
+struct FCoverEdgeWork
+{
+	FCoverEdgeWork(const FVector& v1, const FVector& v2, uint8 profiles) : _v1(v1), _v2(v2), _profiles(profiles)
+	{
+		_edgeDir = (v2 - v1);
+		_edgeLength = _edgeDir.Size();
+		_edgeDir /= _edgeLength;
+	}
+
+	FVector _v1;
+	FVector _v2;
+	FVector _edgeDir;
+	float _edgeLength;
+	uint8 _profiles;
+
+	FVector _obstNormal; // impact normal of the obstacle face this edge is parallel to
+	FVector _faceNormal; // normal of the obstacle face this edge is parallel to
+	FVector _faceLocation; // where the face was hit, in front of the middle of the edge
+	bool _isStandingCover = false; // all profiles of the edge can stand behind the obstacle
+
+	FCoverSideSearch _leftSide;
+	FCoverSideSearch _rightSide;
+
+	TArray<FCoverPointCandidate> _points;
+	int32 _traceIdx = INDEX_NONE;
+};
+
+// internal cover point location on an edge that still has to pass the obstacle height tests
+struct FCoverInternalPointWork
+{
+	FCoverInternalPointWork(int32 edgeIdx, const FVector& location) : _edgeIdx(edgeIdx), _location(location) { }
+
+	int32 _edgeIdx;
+	FVector _location;
+	FVector _facePoint; // where the obstacle face was hit at crouch height
+	bool _isValid = false;
+	int32 _traceIdx = INDEX_NONE;
+	float _obstacleHeight = 0.0f;
+};
+
 struct FCoverPointOctreeElement
 {
-	FCoverPointOctreeElement(UCoverPoint* coverPoint, float extent)
+	FCoverPointOctreeElement(int32 handle, const FVector& location, float extent, TArray<FOctreeElementId>* elementIds)
 	{
-		_coverPoint = coverPoint;
-		_bbox.Center = _coverPoint->_location;
+		_handle = handle;
+		_bbox.Center = location;
 		_bbox.Extent = FVector(extent);
+		_elementIds = elementIds;
 	}
 
 	~FCoverPointOctreeElement(){ }
 	
-	UCoverPoint* _coverPoint;
+	int32 _handle;
 
 	FBoxCenterAndExtent _bbox;
+
+	TArray<FOctreeElementId>* _elementIds; // octree ids of all elements by handle, needed to remove points on incremental updates
 };
 
 struct FCoverPointOctreeSemantics
@@ -68,12 +280,12 @@ struct FCoverPointOctreeSemantics
 
 	FORCEINLINE static bool AreElementsEqual(const FCoverPointOctreeElement& a, const FCoverPointOctreeElement& b)
 	{
-		return a._coverPoint == b._coverPoint;
+		return a._handle == b._handle;
 	}
 
-	/** Ignored for this implementation */
 	FORCEINLINE static void SetElementId(const FCoverPointOctreeElement& Element, FOctreeElementId Id)
 	{
+		(*Element._elementIds)[Element._handle] = Id;
 	}
 };
 
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverExposureCache.h"
+
+void FCoverExposureCache::Init(float range)
+{
+	_range = FMath::Max(range, MinTargetDistance);
+	_distances.Reset();
+}
+
+void FCoverExposureCache::Reset()
+{
+	_range = 0.0f;
+	_distances.Empty();
+}
+
+void FCoverExposureCache::Clear(int32 handle)
+{
+	int32 offset = handle * BytesPerPoint;
+	if (!IsInitialized() || offset >= _distances.Num()) return;
+
+	FMemory::Memzero(_distances.GetData() + offset, BytesPerPoint);
+}
+
+void FCoverExposureCache::Set(int32 handle, ECoverExposureHeight height, int32 sector, float blockedDistance)
+{
+	int32 requiredSize = (handle + 1) * BytesPerPoint;
+	if (_distances.Num() < requiredSize)
+	{
+		_distances.AddZeroed(requiredSize - _distances.Num());
+	}
+
+	// rounding up keeps the stored distance behind the geometry, the quantization never moves a target behind it
+	uint8 quantized = ClearDistance;
+	if (blockedDistance >= 0.0f && blockedDistance < _range)
+	{
+		quantized = (uint8)FMath::Clamp(FMath::CeilToInt(blockedDistance / _range * NumDistanceSteps), 1, NumDistanceSteps);
+	}
+	_distances[handle * BytesPerPoint + (int32)height * NumSectors + sector] = quantized;
+}
+
+ECoverVisibility FCoverExposureCache::Get(int32 handle, const FVector& pointLocation, const FVector& targetLocation, ECoverExposureHeight height) const
+{
+	int32 offset = handle * BytesPerPoint;
+	if (!IsInitialized() || offset >= _distances.Num()) return ECoverVisibility::Unknown;
+
+	FVector delta = targetLocation - pointLocation;
+	float distance = delta.Size2D();
+	if (distance < MinTargetDistance || FMath::Abs(delta.Z) > MaxTargetHeightDifference) return ECoverVisibility::Unknown;
+
+	uint8 quantized = _distances[offset + (int32)height * NumSectors + GetSector(delta)];
+	if (quantized == UnknownDistance) return ECoverVisibility::Unknown;
+	if (quantized == ClearDistance) return distance <= _range ? ECoverVisibility::Visible : ECoverVisibility::Unknown;
+
+	float blockedDistance = quantized * _range / NumDistanceSteps;
+	return distance > blockedDistance ? ECoverVisibility::Hidden : ECoverVisibility::Mixed;
+}
+
+FVector FCoverExposureCache::GetRayDirection(int32 rayIdx)
+{
+	float azimuth = 2.0f * PI * rayIdx / (NumSectors * RaysPerSector);
+	return FVector(FMath::Cos(azimuth), FMath::Sin(azimuth), 0.0f);
+}
+
+void FCoverExposureCache::Serialize(FArchive& ar)
+{
+	ar << _range;
+	_distances.BulkSerialize(ar);
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverVisibilityCache.h"
+
+// height of the agent whose exposure is looked up
+enum class ECoverExposureHeight : uint8
+{
+	Crouch = 0,
+	Stand = 1
+};
+
+/**
+ * Directional exposure of every cover point, built from the static geometry at generation time. The directions around a point are
+ * split into azimuth sectors, every sector stores how far away it is blocked at crouch and at stand height. A threat's bearing and
+ * distance then tell whether it is behind the blocking geometry. Points are addressed by their handle, like in the visibility cache.
+ */
+class COVERSPOTGENERATOR_API FCoverExposureCache
+{
+public:
+	static constexpr int32 NumSectors = 16;
+	static constexpr int32 NumHeights = 2;
+	static constexpr int32 BytesPerPoint = NumSectors * NumHeights;
+	static constexpr int32 RaysPerSector = 2; // every sector is traced at its center and its first edge, the next sector's edge closes it
+
+	void Init(float range);
+	void Reset();
+	FORCEINLINE bool IsInitialized() const { return _range > 0.0f; }
+	FORCEINLINE bool Matches(float range) const { return _range == range; }
+	FORCEINLINE float GetRange() const { return _range; }
+
+	void Clear(int32 handle);
+	// sets the distance at which the sector is blocked, a negative distance means it is clear up to the range
+	void Set(int32 handle, ECoverExposureHeight height, int32 sector, float blockedDistance);
+	// Hidden if the target is behind the blocking geometry of its sector, Visible if the sector is clear up to the target. Targets that are
+	// too close, on another floor, out of range or in front of the blocking geometry need a trace.
+	ECoverVisibility Get(int32 handle, const FVector& pointLocation, const FVector& targetLocation, ECoverExposureHeight height) const;
+
+	// direction of a ray, rays [sector * RaysPerSector, (sector + 1) * RaysPerSector] cover the sector
+	static FVector GetRayDirection(int32 rayIdx);
+
+	void Serialize(FArchive& ar);
+
+private:
+	// sectors are horizontal and coarse, they say little about targets right next to the point or above and below it
+	static constexpr float MinTargetDistance = 200.0f;
+	static constexpr float MaxTargetHeightDifference = 100.0f;
+	static constexpr uint8 UnknownDistance = 0; // not measured
+	static constexpr uint8 ClearDistance = 0xFF;
+	static constexpr int32 NumDistanceSteps = ClearDistance - 1; // blocked distances are stored as 1 to NumDistanceSteps
+
+	FORCEINLINE static int32 GetSector(const FVector& direction)
+	{
+		float azimuth = FMath::Atan2(direction.Y, direction.X);
+		if (azimuth < 0.0f) azimuth += 2.0f * PI;
+		return FMath::Min((int32)(azimuth / (2.0f * PI) * NumSectors), NumSectors - 1);
+	}
+
+	float _range = 0.0f;
+	TArray<uint8> _distances; // quantized blocked distance, BytesPerPoint bytes per handle with the stand sectors after the crouch sectors
+};
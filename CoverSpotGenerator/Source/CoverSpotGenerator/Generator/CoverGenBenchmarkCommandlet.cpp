@@ -0,0 +1,264 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverGenBenchmarkCommandlet.h"
+
+#include "CoverPointGenerator.h"
+#include "CoverRaycaster.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "NavigationSystem.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_EDITOR
+#include "Builders/CubeBuilder.h"
+#include "ActorFactories/ActorFactory.h"
+#endif
+
+// generation modes that are compared on every level
+struct FCoverGenBenchmarkMode
+{
+	const TCHAR* _name;
+	bool _async;
+	bool _parallel;
+	bool _timeSliced;
+};
+
+static const FCoverGenBenchmarkMode BenchmarkModes[] =
+{
+	{ TEXT("Sync"), false, false, false },
+	{ TEXT("SyncParallel"), false, true, false },
+	{ TEXT("Async"), true, false, false },
+	{ TEXT("AsyncParallel"), true, true, false },
+	{ TEXT("TimeSliced"), false, false, true },
+};
+
+enum class ECoverGenBenchmarkLevel : uint8
+{
+	WallGrid,
+	PillarField,
+	UrbanBlocks
+};
+
+static const float BenchmarkTickTime = 1.0f / 60.0f;
+static const float BenchmarkTimeout = 600.0f; // seconds a single generation may take before the benchmark gives up on it
+
+UCoverGenBenchmarkCommandlet::UCoverGenBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+#if WITH_EDITOR
+
+// Adds a box with the given center and full size, built from the engine's unit cube (100 units)
+static void AddBox(UWorld* world, UStaticMesh* cube, const FVector& center, const FVector& size)
+{
+	FTransform transform(FRotator::ZeroRotator, center, size / 100.0f);
+
+	// the mesh has to be set before the (static) component is registered
+	AStaticMeshActor* actor = world->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), transform);
+	actor->GetStaticMeshComponent()->SetStaticMesh(cube);
+	actor->FinishSpawning(transform);
+}
+
+// Fills the world with the obstacles of the level, returns the bounds of the level
+static FBox BuildLevel(UWorld* world, UStaticMesh* cube, ECoverGenBenchmarkLevel level, int32 scale)
+{
+	FRandomStream random(scale);
+	float cellSize = 0.0f;
+
+	for (int32 x = 0; x < scale; x++)
+	{
+		for (int32 y = 0; y < scale; y++)
+		{
+			switch (level)
+			{
+			case ECoverGenBenchmarkLevel::WallGrid:
+			{
+				// alternating crouch and standing walls, rotated every other cell
+				cellSize = 800.0f;
+				FVector center(x * cellSize, y * cellSize, 0.0f);
+				float height = (x + y) % 2 == 0 ? 130.0f : 250.0f;
+				FVector size = (x % 2 == 0) ? FVector(400.0f, 30.0f, height) : FVector(30.0f, 400.0f, height);
+				AddBox(world, cube, center + FVector(0.0f, 0.0f, height * 0.5f), size);
+				break;
+			}
+			case ECoverGenBenchmarkLevel::PillarField:
+			{
+				cellSize = 400.0f;
+				FVector center(x * cellSize, y * cellSize, 150.0f);
+				AddBox(world, cube, center, FVector(60.0f, 60.0f, 300.0f));
+				break;
+			}
+			case ECoverGenBenchmarkLevel::UrbanBlocks:
+			{
+				// buildings separated by streets, cluttered with car sized boxes
+				cellSize = 2000.0f;
+				FVector center(x * cellSize, y * cellSize, 300.0f);
+				AddBox(world, cube, center, FVector(1200.0f, 1200.0f, 600.0f));
+
+				for (int32 carIdx = 0; carIdx < 4; carIdx++)
+				{
+					FVector carCenter(center.X + 1000.0f, center.Y + random.FRandRange(-800.0f, 800.0f), 75.0f);
+					AddBox(world, cube, carCenter, FVector(200.0f, 450.0f, 150.0f));
+				}
+				break;
+			}
+			}
+		}
+	}
+
+	FBox bounds(FVector(-cellSize, -cellSize, -50.0f), FVector(scale * cellSize, scale * cellSize, 700.0f));
+
+	// floor
+	FVector floorSize = bounds.GetSize();
+	floorSize.Z = 20.0f;
+	AddBox(world, cube, FVector(bounds.GetCenter().X, bounds.GetCenter().Y, 0.0f), floorSize);
+
+	return bounds;
+}
+
+static void BuildNavMesh(UWorld* world, const FBox& bounds)
+{
+	ANavMeshBoundsVolume* volume = world->SpawnActor<ANavMeshBoundsVolume>(bounds.GetCenter(), FRotator::ZeroRotator);
+
+	UCubeBuilder* builder = NewObject<UCubeBuilder>();
+	builder->X = bounds.GetSize().X;
+	builder->Y = bounds.GetSize().Y;
+	builder->Z = bounds.GetSize().Z;
+	UActorFactory::CreateBrushForVolumeActor(volume, builder);
+
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	navSystem->OnNavigationBoundsUpdated(volume);
+	navSystem->Build();
+}
+
+static UWorld* CreateBenchmarkWorld()
+{
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CoverGenBenchmark"));
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+
+	FNavigationSystem::AddNavigationSystemToWorld(*world, FNavigationSystemRunMode::GameMode);
+	world->InitializeActorsForPlay(FURL());
+	world->BeginPlay();
+
+	return world;
+}
+
+static void DestroyBenchmarkWorld(UWorld* world)
+{
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	CollectGarbage(RF_NoFlags);
+}
+
+// runs one generation of the whole level, the generation is done once its set is published
+static FString RunGeneration(UWorld* world, ACoverPointGenerator* generator, const FBox& bounds, const FCoverGenBenchmarkMode& mode)
+{
+	generator->_asyncGeneration = mode._async;
+	generator->_parallelGeneration = mode._parallel;
+	generator->_timeSlicedGeneration = mode._timeSliced;
+
+	const int64 tracesBefore = FCoverRaycastBatch::GetTotalNumTraces();
+	const uint64 memoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	const double startTime = FPlatformTime::Seconds();
+
+	generator->UpdateCoverpointData(bounds);
+	while (generator->IsGenerationInProgress() && FPlatformTime::Seconds() - startTime < BenchmarkTimeout)
+	{
+		world->Tick(LEVELTICK_All, BenchmarkTickTime);
+	}
+
+	const double wallTime = FPlatformTime::Seconds() - startTime;
+	const FPlatformMemoryStats memory = FPlatformMemory::GetStats();
+	FCoverPointSetPtr coverPoints = generator->GetCoverPoints();
+
+	return FString::Printf(TEXT("\"mode\": \"%s\", \"completed\": %s, \"wallTimeMs\": %.3f, \"traces\": %lld, \"points\": %d, \"memoryDeltaBytes\": %lld, \"peakMemoryBytes\": %llu"),
+		mode._name, generator->IsGenerationInProgress() ? TEXT("false") : TEXT("true"), wallTime * 1000.0, FCoverRaycastBatch::GetTotalNumTraces() - tracesBefore,
+		coverPoints.IsValid() ? coverPoints->_store.Num() : 0, (int64)memory.UsedPhysical - (int64)memoryBefore, (uint64)memory.PeakUsedPhysical);
+}
+
+int32 UCoverGenBenchmarkCommandlet::Main(const FString& params)
+{
+	TArray<int32> scales = { 4, 8, 16 };
+	FString scalesParam;
+	if (FParse::Value(*params, TEXT("scales="), scalesParam))
+	{
+		TArray<FString> scaleStrings;
+		scalesParam.ParseIntoArray(scaleStrings, TEXT(","));
+		scales.Reset();
+		for (const FString& scaleString : scaleStrings)
+		{
+			int32 scale = FCString::Atoi(*scaleString);
+			if (scale > 0) scales.Add(scale);
+		}
+	}
+
+	FString outputPath = FPaths::ProjectSavedDir() / TEXT("CoverGenBenchmark.json");
+	FParse::Value(*params, TEXT("output="), outputPath);
+
+	UStaticMesh* cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!cube)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cover generation benchmark: could not load the engine's cube mesh"));
+		return 1;
+	}
+
+	const TPair<ECoverGenBenchmarkLevel, const TCHAR*> levels[] =
+	{
+		{ ECoverGenBenchmarkLevel::WallGrid, TEXT("WallGrid") },
+		{ ECoverGenBenchmarkLevel::PillarField, TEXT("PillarField") },
+		{ ECoverGenBenchmarkLevel::UrbanBlocks, TEXT("UrbanBlocks") },
+	};
+
+	// one JSON object per line and generation
+	TArray<FString> results;
+	for (const TPair<ECoverGenBenchmarkLevel, const TCHAR*>& level : levels)
+	{
+		for (int32 scale : scales)
+		{
+			UWorld* world = CreateBenchmarkWorld();
+			FBox bounds = BuildLevel(world, cube, level.Key, scale);
+			BuildNavMesh(world, bounds);
+
+			ACoverPointGenerator* generator = world->SpawnActor<ACoverPointGenerator>();
+			for (const FCoverGenBenchmarkMode& mode : BenchmarkModes)
+			{
+				FString result = FString::Printf(TEXT("{ \"level\": \"%s\", \"scale\": %d, %s }"), level.Value, scale, *RunGeneration(world, generator, bounds, mode));
+				UE_LOG(LogTemp, Display, TEXT("%s"), *result);
+				results.Add(result);
+			}
+
+			DestroyBenchmarkWorld(world);
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(FString::Printf(TEXT("[\n%s\n]\n"), *FString::Join(results, TEXT(",\n"))), *outputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cover generation benchmark: could not write %s"), *outputPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Cover generation benchmark written to %s"), *outputPath);
+	return 0;
+}
+
+#else
+
+int32 UCoverGenBenchmarkCommandlet::Main(const FString& params)
+{
+	UE_LOG(LogTemp, Error, TEXT("The cover generation benchmark needs an editor build"));
+	return 1;
+}
+
+#endif
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "CoverGenBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmark of the cover point generation. Builds synthetic levels (wall grids, pillar fields and urban blocks at several scales)
+ * with their navmesh, generates their cover points in every generation mode and writes wall time, traces, points and memory as JSON.
+ * Usage: UE4Editor-Cmd <project> -run=CoverGenBenchmark -nullrhi [-scales=4,8,16] [-output=<file>]
+ */
+UCLASS()
+class COVERSPOTGENERATOR_API UCoverGenBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCoverGenBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& params) override;
+};
@@ -0,0 +1,928 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverGenerationCore.h"
+
+#include "CoverGenerationStats.h"
+
+// distance behind the obstacle face at which the height probe goes down. The probe misses obstacles thinner than this.
+static const float HeightProbeDepth = 5.0f;
+
+// obstacle height of a probe that missed the obstacle
+static const float UnknownObstacleHeight = -1.0f;
+
+/*
+---------- Generation ------------
+*/
+
+// Recast splits a wall into an edge for every tile and polygon along it. Generating per fragment repeats the obstacle face search for
+// every fragment, searches for sides at vertices that are no corners and spaces the internal points per fragment.
+int32 FCoverGenerationCore::MergeWallSegments(TArray<FVector>& vertices, TArray<FCoverNavEdge>& navEdges, float maxDeviation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_EdgeExtraction);
+
+	const int32 numEdges = navEdges.Num();
+	if (numEdges < 2) return 0;
+
+	// a vertex joins two edges only if exactly one edge ends and one edge starts there, otherwise multiple boundaries meet
+	TArray<int32> outgoingEdges;
+	TArray<uint8> numIncoming;
+	TArray<uint8> numOutgoing;
+	outgoingEdges.Init(INDEX_NONE, vertices.Num());
+	numIncoming.Init(0, vertices.Num());
+	numOutgoing.Init(0, vertices.Num());
+	for (int32 edgeIdx = 0; edgeIdx < numEdges; edgeIdx++)
+	{
+		const FCoverNavEdge& edge = navEdges[edgeIdx];
+		outgoingEdges[edge._v1] = edgeIdx;
+		numOutgoing[edge._v1] = (uint8)FMath::Min(numOutgoing[edge._v1] + 1, 2);
+		numIncoming[edge._v2] = (uint8)FMath::Min(numIncoming[edge._v2] + 1, 2);
+	}
+
+	// link every edge to the edge that continues it in a straight line
+	TArray<int32> nextEdges;
+	TArray<bool> hasPreviousEdge;
+	nextEdges.Init(INDEX_NONE, numEdges);
+	hasPreviousEdge.Init(false, numEdges);
+	for (int32 edgeIdx = 0; edgeIdx < numEdges; edgeIdx++)
+	{
+		const FCoverNavEdge& edge = navEdges[edgeIdx];
+		if (numOutgoing[edge._v2] != 1 || numIncoming[edge._v2] != 1) continue;
+
+		int32 nextIdx = outgoingEdges[edge._v2];
+		const FCoverNavEdge& nextEdge = navEdges[nextIdx];
+		if (nextIdx == edgeIdx || nextEdge._profiles != edge._profiles) continue;
+		if (FMath::PointDistToSegment(vertices[edge._v2], vertices[edge._v1], vertices[nextEdge._v2]) > maxDeviation) continue;
+
+		nextEdges[edgeIdx] = nextIdx;
+		hasPreviousEdge[nextIdx] = true;
+	}
+
+	// follow the links, a segment ends where the next edge would move one of its vertices too far from the line between its ends
+	TArray<FCoverNavEdge> segments;
+	segments.Reserve(numEdges);
+	TArray<bool> merged;
+	merged.Init(false, numEdges);
+	TArray<int32, TInlineAllocator<32>> innerVertices;
+	auto mergeChain = [&](int32 edgeIdx)
+	{
+		while (edgeIdx != INDEX_NONE && !merged[edgeIdx])
+		{
+			FCoverNavEdge segment = navEdges[edgeIdx];
+			merged[edgeIdx] = true;
+			innerVertices.Reset();
+
+			int32 nextIdx = nextEdges[edgeIdx];
+			while (nextIdx != INDEX_NONE && !merged[nextIdx])
+			{
+				const FVector& segmentStart = vertices[segment._v1];
+				const FVector& segmentEnd = vertices[navEdges[nextIdx]._v2];
+				innerVertices.Add(segment._v2);
+
+				bool isStraight = true;
+				for (int32 vertIdx : innerVertices)
+				{
+					if (FMath::PointDistToSegment(vertices[vertIdx], segmentStart, segmentEnd) > maxDeviation)
+					{
+						isStraight = false;
+						break;
+					}
+				}
+				if (!isStraight) break;
+
+				segment._v2 = navEdges[nextIdx]._v2;
+				merged[nextIdx] = true;
+				nextIdx = nextEdges[nextIdx];
+			}
+
+			segments.Add(segment);
+			edgeIdx = nextIdx;
+		}
+	};
+
+	// chains start at edges without a previous edge, what is left are closed loops of linked edges
+	for (int32 edgeIdx = 0; edgeIdx < numEdges; edgeIdx++)
+	{
+		if (!hasPreviousEdge[edgeIdx]) mergeChain(edgeIdx);
+	}
+	for (int32 edgeIdx = 0; edgeIdx < numEdges; edgeIdx++)
+	{
+		mergeChain(edgeIdx);
+	}
+
+	// drop the inner vertices of the segments, so they are not projected either
+	TArray<int32> vertexRemap;
+	vertexRemap.Init(INDEX_NONE, vertices.Num());
+	TArray<FVector> segmentVertices;
+	for (FCoverNavEdge& segment : segments)
+	{
+		for (int32* vertIdx : { &segment._v1, &segment._v2 })
+		{
+			if (vertexRemap[*vertIdx] == INDEX_NONE) vertexRemap[*vertIdx] = segmentVertices.Add(vertices[*vertIdx]);
+			*vertIdx = vertexRemap[*vertIdx];
+		}
+	}
+
+	vertices = MoveTemp(segmentVertices);
+	navEdges = MoveTemp(segments);
+
+	return numEdges - navEdges.Num();
+}
+
+void FCoverGenerationCore::ProjectVertices(TArray<FVector>& vertices, int32 firstVertex, int32 numVertices, TFunctionRef<bool()> isCancelled) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_GroundProjection);
+
+	// vertices are projected in chunks, so a cancelled generation does not wait for the projection of a big area
+	const int32 verticesPerBatch = 1024;
+
+	FCoverRaycastBatch traces;
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_GroundProjectionTraces);
+	for (int32 chunkStart = firstVertex; chunkStart < firstVertex + numVertices; chunkStart += verticesPerBatch)
+	{
+		if (isCancelled()) return;
+
+		traces.Reset();
+		int32 chunkEnd = FMath::Min(chunkStart + verticesPerBatch, firstVertex + numVertices);
+		for (int32 vertIdx = chunkStart; vertIdx < chunkEnd; vertIdx++)
+		{
+			const FVector& vertex = vertices[vertIdx];
+			traces.Add(vertex, vertex + FVector::DownVector * _params._maxProjectionHeight);
+		}
+		traces.Execute(_raycaster);
+
+		for (int32 traceIdx = 0; traceIdx < chunkEnd - chunkStart; traceIdx++)
+		{
+			const FCoverRaycastHit& projectHit = traces.GetHit(traceIdx);
+			if (projectHit._blockingHit) vertices[chunkStart + traceIdx] = projectHit._location;
+		}
+	}
+}
+
+void FCoverGenerationCore::GenerateCoverPoints(const TArray<FVector>& vertices, const TArray<FCoverNavEdge>& navEdges, int32 firstEdge, int32 numEdges, const FBox& bbox,
+	FCoverPointSet& coverPoints, TArray<int32>& outNewHandles, TFunctionRef<bool()> isCancelled) const
+{
+	TArray<FCoverEdgeWork> edges;
+	edges.Reserve(numEdges);
+	for (int32 edgeIdx = firstEdge; edgeIdx < firstEdge + numEdges; edgeIdx++)
+	{
+		const FVector& v1 = vertices[navEdges[edgeIdx]._v1];
+		const FVector& v2 = vertices[navEdges[edgeIdx]._v2];
+		if (!FMath::LineBoxIntersection(bbox, v1, v2, (v2 - v1))) continue;
+
+		edges.Emplace(v1, v2, navEdges[edgeIdx]._profiles);
+	}
+
+	// run the stages: every stage submits the traces of all edges as one batch and the next stage consumes the results.
+	// A cancelled generation stops between stages.
+	INC_DWORD_STAT_BY(STAT_CoverGen_EdgesCulled, numEdges - edges.Num());
+	const int32 numEdgesInBounds = edges.Num();
+
+	FCoverRaycastBatch traces;
+	FindObstacleFaces(edges, traces);
+	INC_DWORD_STAT_BY(STAT_CoverGen_EdgesWithoutObstacle, numEdgesInBounds - edges.Num());
+	INC_DWORD_STAT_BY(STAT_CoverGen_EdgesAccepted, edges.Num());
+	if (isCancelled()) return;
+	FindSideCoverPoints(edges, traces);
+	if (isCancelled()) return;
+	ClassifySidePoints(edges, coverPoints, bbox, traces);
+	if (isCancelled()) return;
+	GenerateInternalPoints(edges, coverPoints, bbox, traces);
+	if (isCancelled()) return;
+
+	// Store in edge order so the result does not depend on thread scheduling. Edges did not see each others points,
+	// so the minimum distance check is repeated against the points that were already stored.
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_IndexInsert);
+	for (const FCoverEdgeWork& edge : edges)
+	{
+		INC_DWORD_STAT_BY(STAT_CoverGen_PointsProduced, edge._points.Num());
+		for (FCoverPointCandidate candidate : edge._points)
+		{
+			if (candidate._profiles == 0) continue;
+
+			// only store the point for the profiles that have no point nearby yet
+			candidate._profiles = GetProfilesWithoutCoverPoint(coverPoints, candidate._location, candidate._profiles);
+			if (candidate._profiles != 0)
+			{
+				outNewHandles.Add(StoreNewCoverPoint(coverPoints, candidate));
+			}
+			else
+			{
+				INC_DWORD_STAT(STAT_CoverGen_PointsDeduplicated);
+			}
+		}
+	}
+}
+
+int64 FCoverGenerationCore::SearchObstacleSides(const TArray<FVector>& vertices, const TArray<FCoverNavEdge>& navEdges, TArray<FVector>& outSidePoints) const
+{
+	TArray<FCoverEdgeWork> edges;
+	edges.Reserve(navEdges.Num());
+	for (const FCoverNavEdge& navEdge : navEdges)
+	{
+		edges.Emplace(vertices[navEdge._v1], vertices[navEdge._v2], navEdge._profiles);
+	}
+
+	FCoverRaycastBatch traces;
+	FindObstacleFaces(edges, traces);
+
+	const int64 tracesBefore = FCoverRaycastBatch::GetTotalNumTraces();
+	FindSideCoverPoints(edges, traces);
+	const int64 numTraces = FCoverRaycastBatch::GetTotalNumTraces() - tracesBefore;
+
+	for (const FCoverEdgeWork& edge : edges)
+	{
+		if (edge._leftSide._isValid) outSidePoints.Add(edge._leftSide._sidePoint);
+		if (edge._rightSide._isValid) outSidePoints.Add(edge._rightSide._sidePoint);
+	}
+
+	return numTraces;
+}
+
+// Calls func for the left and right side search of every edge.
+template<typename TFunc>
+static void ForEachSideSearch(TArray<FCoverEdgeWork>& edges, TFunc func)
+{
+	for (FCoverEdgeWork& edge : edges)
+	{
+		func(edge, edge._leftSide);
+		func(edge, edge._rightSide);
+	}
+}
+
+void FCoverGenerationCore::FindObstacleFaces(TArray<FCoverEdgeWork>& edges, FCoverRaycastBatch& traces) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_FaceNormal);
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_FaceNormalTraces);
+
+	// get the normal of the obstacle face each edge is parallel to
+	traces.Reset();
+	for (FCoverEdgeWork& edge : edges)
+	{
+		FVector rightVec = FVector::CrossProduct(FVector::UpVector, edge._edgeDir);
+		FVector checkStart = edge._v1 + edge._edgeDir * edge._edgeLength * 0.5f;
+		checkStart.Z += 20.0f;
+		FVector checkStop = checkStart + rightVec * _params._obstacleCheckDistance;
+
+		edge._traceIdx = traces.Add(checkStart, checkStop);
+	}
+	traces.Execute(_raycaster);
+
+	for (FCoverEdgeWork& edge : edges)
+	{
+		const FCoverRaycastHit& hit = traces.GetHit(edge._traceIdx);
+		edge._obstNormal = hit._impactNormal;
+		edge._faceNormal = hit._normal;
+		edge._faceLocation = hit._location;
+	}
+
+	// edges that do not run along an obstacle cannot provide cover
+	edges.RemoveAll([&traces](const FCoverEdgeWork& edge) { return !traces.GetHit(edge._traceIdx)._blockingHit; });
+}
+
+// The navigation mesh is not perfect. Therefore, we cannot assume that nav-mesh edges perfectly represent obstacle information. This stage performs a sweep test 
+//  along the obstacle to find the sides of an obstacle, starting at both vertices of every edge.
+void FCoverGenerationCore::FindSideCoverPoints(TArray<FCoverEdgeWork>& edges, FCoverRaycastBatch& traces) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_SideSweep);
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_SideSweepTraces);
+
+	// decide whether we should search along the left or right to find a cover spot
+	traces.Reset();
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (&side == &edge._leftSide)
+		{
+			side.Init(edge._v2, FVector::CrossProduct(FVector::UpVector, edge._obstNormal), edge._edgeDir, GetLowestCrouchHeight(edge._profiles));
+		}
+		else
+		{
+			side.Init(edge._v1, -FVector::CrossProduct(FVector::UpVector, edge._obstNormal), -edge._edgeDir, GetLowestCrouchHeight(edge._profiles));
+		}
+
+		side._traceIdx = traces.Add(side._startPoint, side._startPoint + -edge._obstNormal * _params._obstacleCheckDistance);
+	});
+	traces.Execute(_raycaster);
+
+	// Find side cover point: sweep direction depends on whether we're already in front of the obstacle or not.
+	// If sweeping in lean direction: currently not in front of obstacle, stop with the first line trace that intersects the obstacle.
+	// If sweeping in opposite lean direction: currently in front of obstacle, stop wtih the first line trace that does not intersect the obstacle, store last intersection.
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		const FCoverRaycastHit& projectHit = traces.GetHit(side._traceIdx);
+		side._sweepInLeanDir = projectHit._blockingHit;
+		side._sweepDirection = side._sweepInLeanDir ? side._sweepDirection : -side._sweepDirection;
+		side._lastDistance = projectHit._distance;
+		side._searching = true;
+	});
+
+	// Every sweep step is one batch containing the next trace of all searches that did not find the obstacle's side yet. The linear search
+	// steps by _obstacleSideCheckInterval and stops at the first trace past the side. The adaptive search doubles its step until it passed
+	// the side, then bisects between the last trace before and the first trace past the side until they are _sideSearchTolerance apart.
+	const bool adaptiveSearch = _params._sideSearchMode == ECoverSideSearchMode::Adaptive;
+	const float searchInterval = FMath::Max(_params._obstacleSideCheckInterval, 0.1f);
+	const float maxSearchOffset = adaptiveSearch ? FMath::Max(_params._sideSearchMaxDistance, searchInterval) : _params._numObstacleSideChecks * searchInterval;
+	const float searchTolerance = adaptiveSearch ? FMath::Max(_params._sideSearchTolerance, 0.1f) : searchInterval;
+	const float offsetEpsilon = 0.01f;
+	while (true)
+	{
+		traces.Reset();
+		ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+		{
+			if (!side._searching) return;
+
+			if (side._changedOffset >= 0.0f)
+			{
+				side._probeOffset = (side._clearOffset + side._changedOffset) * 0.5f;
+			}
+			else if (side._clearOffset < maxSearchOffset - offsetEpsilon)
+			{
+				float step = adaptiveSearch && side._clearOffset > 0.0f ? side._clearOffset : searchInterval;
+				side._probeOffset = FMath::Min(side._clearOffset + step, maxSearchOffset);
+			}
+			else
+			{
+				// side not found within reach
+				side._searching = false;
+				return;
+			}
+
+			FVector start = side._startPoint + side._probeOffset * side._sweepDirection;
+			FVector stop = start + -edge._obstNormal * _params._obstacleCheckDistance;
+			side._traceIdx = traces.Add(start, stop);
+		});
+
+		if (traces.Num() == 0) break;
+		traces.Execute(_raycaster);
+
+		ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+		{
+			if (!side._searching) return;
+
+			const FCoverRaycastHit& sideHitCheck = traces.GetHit(side._traceIdx);
+			if (side._sweepInLeanDir != sideHitCheck._blockingHit)
+			{
+				side._changedOffset = side._probeOffset;
+				side._changedDistance = sideHitCheck._distance;
+			}
+			else
+			{
+				side._clearOffset = side._probeOffset;
+				side._lastDistance = sideHitCheck._distance;
+			}
+
+			if (side._changedOffset < 0.0f || side._changedOffset - side._clearOffset > searchTolerance + offsetEpsilon) return;
+
+			// edge found: offset the resulting point from the obstacle such that there is a clearance of _coverPointOffset
+			float distToObstacle = side._sweepInLeanDir ? side._lastDistance : side._changedDistance;
+			float offsetFromObstacle = distToObstacle - _params._coverPointOffset;
+			float leanOffset = side._sweepInLeanDir ? _params._coverPointOffset + (side._changedOffset - side._clearOffset) : _params._coverPointOffset;
+
+			FVector start = side._startPoint + side._changedOffset * side._sweepDirection;
+			side._sidePoint = start - side._leanDirection * leanOffset + -edge._obstNormal * offsetFromObstacle;
+			side._foundEndPoint = true;
+			side._searching = false;
+		});
+	}
+
+	// make sure resulting side cover point is valid (may not be true due to nav-mesh imperfections)
+	traces.Reset();
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		side._searching = false;
+		if (!side._foundEndPoint) return;
+
+		FVector visionFromSideCheckStart = side._sidePoint + side._leanDirection * (_params._sideLeanOffset + _params._coverPointOffset);
+		FVector visionFromSideCheckStop = visionFromSideCheckStart + -edge._obstNormal * _params._obstacleCheckDistance;
+		side._traceIdx = traces.Add(visionFromSideCheckStart, visionFromSideCheckStop);
+	});
+	traces.Execute(_raycaster);
+
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (!side._foundEndPoint) return;
+
+		if (!traces.GetHit(side._traceIdx)._blockingHit)
+		{
+			// vision not blocked from side: valid side cover point
+			side._sidePoint.Z -= side._sweepHeight;
+			side._isValid = true;
+		}
+	});
+}
+
+void FCoverGenerationCore::ClassifySidePoints(TArray<FCoverEdgeWork>& edges, const FCoverPointSet& coverPoints, const FBox& bbox, FCoverRaycastBatch& traces) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_SideClassification);
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_SideClassificationTraces);
+
+	// add the side points of each edge, the left point is added first so the right point is checked against it
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (!side._isValid || !InsideGenerationVolume(side._sidePoint, bbox)) return;
+
+		uint8 profiles = GetProfilesWithoutCoverPoint(coverPoints, side._sidePoint, edge._profiles, edge._points);
+		if (profiles == 0) return;
+
+		side._pointIdx = edge._points.Emplace(side._sidePoint, -edge._obstNormal, side._leanDirection, false, 0.0f, profiles);
+	});
+
+	// measure the obstacle height at the side points. The sweep found the face at sweep height, side points keep a clearance of
+	// _coverPointOffset to it. If not "complex can lean over obstacle test", also measure it once at middle of edge (may be too coarse).
+	traces.Reset();
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (side._pointIdx == INDEX_NONE) return;
+
+		FVector facePoint = side._sidePoint + -edge._obstNormal * _params._coverPointOffset;
+		facePoint.Z += side._sweepHeight;
+		side._traceIdx = AddObstacleHeightProbe(traces, facePoint, edge._obstNormal, side._sidePoint.Z);
+	});
+	if (!_params._complexCanLeanOverObstacleTest)
+	{
+		for (FCoverEdgeWork& edge : edges)
+		{
+			edge._traceIdx = AddObstacleHeightProbe(traces, edge._faceLocation, edge._faceNormal, (edge._v1.Z + edge._v2.Z) * 0.5f);
+		}
+	}
+	traces.Execute(_raycaster);
+
+	// an edge whose probe missed is no standing cover, its internal points are measured one by one
+	if (!_params._complexCanLeanOverObstacleTest)
+	{
+		for (FCoverEdgeWork& edge : edges)
+		{
+			edge._isStandingCover = GetObstacleHeight(traces, edge._traceIdx, (edge._v1.Z + edge._v2.Z) * 0.5f) >= GetHighestStandHeight(edge._profiles);
+		}
+	}
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (side._pointIdx == INDEX_NONE) return;
+		side._obstacleHeight = GetObstacleHeight(traces, side._traceIdx, side._sidePoint.Z);
+	});
+
+	// a probe that missed did not measure the obstacle: it is only known to be as high as the sweep that found the face, unless
+	// a trace at stand height confirms it
+	traces.Reset();
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (side._pointIdx == INDEX_NONE || side._obstacleHeight != UnknownObstacleHeight) return;
+		side._traceIdx = AddObstacleHeightTrace(traces, side._sidePoint, edge._obstNormal, GetHighestStandHeight(edge._points[side._pointIdx]._profiles));
+	});
+	traces.Execute(_raycaster);
+
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (side._pointIdx == INDEX_NONE || side._obstacleHeight != UnknownObstacleHeight) return;
+		side._obstacleHeight = traces.GetHit(side._traceIdx)._blockingHit ? GetHighestStandHeight(edge._points[side._pointIdx]._profiles) : side._sweepHeight;
+	});
+
+	// An agent can stand if the obstacle is high enough, otherwise check if it can lean over the obstacle. Profiles that use the
+	// side point in different ways get their own point at the same location.
+	ForEachSideSearch(edges, [&](FCoverEdgeWork& edge, FCoverSideSearch& side)
+	{
+		if (side._pointIdx == INDEX_NONE) return;
+
+		const float obstacleHeight = side._obstacleHeight;
+		uint8 profileClasses[3];
+		ClassifyProfiles(edge._points[side._pointIdx]._profiles, obstacleHeight, profileClasses);
+
+		const FCoverPointCandidate sidePoint = edge._points[side._pointIdx];
+		edge._points[side._pointIdx]._profiles = 0; // stays empty if the obstacle covers none of the profiles
+		bool reuseSidePoint = true;
+		for (int32 classIdx = 0; classIdx < 3; classIdx++)
+		{
+			if (profileClasses[classIdx] == 0) continue;
+
+			FCoverPointCandidate& point = reuseSidePoint ? edge._points[side._pointIdx] : edge._points[edge._points.Add(sidePoint)];
+			point._profiles = profileClasses[classIdx];
+			point._obstacleHeight = obstacleHeight;
+			point._canStand = classIdx == 2;
+			point._leanDirection.Z = classIdx == 1 ? 1.0f : 0.0f;
+			reuseSidePoint = false;
+		}
+	});
+}
+
+void FCoverGenerationCore::GenerateInternalPoints(TArray<FCoverEdgeWork>& edges, const FCoverPointSet& coverPoints, const FBox& bbox, FCoverRaycastBatch& traces) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_InternalPoints);
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_InternalPointTraces);
+
+	TArray<FCoverInternalPointWork> internalPoints;
+	for (int32 edgeIdx = 0; edgeIdx < edges.Num(); edgeIdx++)
+	{
+		const FCoverEdgeWork& edge = edges[edgeIdx];
+		if (edge._isStandingCover) continue;
+
+		// get the edge between the two side cover points
+		bool hasLeftSidePoint = edge._leftSide._pointIdx != INDEX_NONE;
+		bool hasRightSidePoint = edge._rightSide._pointIdx != INDEX_NONE;
+		FVector leftPoint = hasLeftSidePoint ? edge._leftSide._sidePoint : edge._v2;
+		FVector rightPoint = hasRightSidePoint ? edge._rightSide._sidePoint : edge._v1;
+
+		FVector internalEdge = (leftPoint - rightPoint);
+		float internalEdgeLength = internalEdge.Size();
+		internalEdge /= internalEdgeLength;
+
+		int numInternalPoints = (int)(internalEdgeLength / _params._coverPointMinDistanceOnEdge) + 1;
+		if (numInternalPoints <= 1) continue;
+
+		// optionally clamp to max. number of cover points for nav mesh edge
+		if (_params._maxNumPointsPerEdge > -1) numInternalPoints = FMath::Clamp<int>(numInternalPoints, 0, _params._maxNumPointsPerEdge);
+		float coverPointInterval = internalEdgeLength / (float)(numInternalPoints - 1);
+
+		FVector startLoc = rightPoint;
+
+		// check if we should place a cover spot on right end point of nav edge
+		if (hasRightSidePoint || GetProfilesWithoutCoverPoint(coverPoints, startLoc, edge._profiles, edge._points) == 0)
+		{
+			// move the starting position further along the internal edge and decrease the total number of internal points
+			startLoc += internalEdge * coverPointInterval;
+			numInternalPoints--;
+		}
+		// check if we should place a cover spot on left end point of nav edge
+		FVector endLoc = startLoc + internalEdge * coverPointInterval * (numInternalPoints - 1);
+		if (hasLeftSidePoint || GetProfilesWithoutCoverPoint(coverPoints, endLoc, edge._profiles, edge._points) == 0)
+		{
+			numInternalPoints--;
+		}
+
+		for (int idx = 0; idx < numInternalPoints; idx++)
+		{
+			FVector pointLocation = startLoc + idx * internalEdge * coverPointInterval;
+			if (!InsideGenerationVolume(pointLocation, bbox)) continue;
+
+			internalPoints.Emplace(edgeIdx, pointLocation);
+		}
+	}
+
+	// an internal point can only be useful if one can lean over it (internal points are not at the sides of obstacles).
+	// The provides cover trace confirms the obstacle and finds its face, the height probe behind the face measures the obstacle.
+	traces.Reset();
+	for (FCoverInternalPointWork& point : internalPoints)
+	{
+		const FCoverEdgeWork& edge = edges[point._edgeIdx];
+		point._traceIdx = AddObstacleHeightTrace(traces, point._location, edge._faceNormal, GetLowestCrouchHeight(edge._profiles));
+	}
+	traces.Execute(_raycaster);
+
+	for (FCoverInternalPointWork& point : internalPoints)
+	{
+		const FCoverRaycastHit& coverHit = traces.GetHit(point._traceIdx);
+		point._isValid = coverHit._blockingHit;
+		point._facePoint = coverHit._location;
+	}
+
+	traces.Reset();
+	for (FCoverInternalPointWork& point : internalPoints)
+	{
+		// only points that provide cover are measured
+		if (!point._isValid) continue;
+		point._traceIdx = AddObstacleHeightProbe(traces, point._facePoint, edges[point._edgeIdx]._faceNormal, point._location.Z);
+	}
+	traces.Execute(_raycaster);
+
+	for (FCoverInternalPointWork& point : internalPoints)
+	{
+		if (!point._isValid) continue;
+		point._obstacleHeight = GetObstacleHeight(traces, point._traceIdx, point._location.Z);
+	}
+
+	// a probe that missed did not measure the obstacle: it is only known to be as high as the provides cover trace, unless a trace
+	// at stand height confirms it
+	traces.Reset();
+	for (FCoverInternalPointWork& point : internalPoints)
+	{
+		if (!point._isValid || point._obstacleHeight != UnknownObstacleHeight) continue;
+		const FCoverEdgeWork& edge = edges[point._edgeIdx];
+		point._traceIdx = AddObstacleHeightTrace(traces, point._location, edge._faceNormal, GetHighestStandHeight(edge._profiles));
+	}
+	traces.Execute(_raycaster);
+
+	for (FCoverInternalPointWork& point : internalPoints)
+	{
+		if (!point._isValid || point._obstacleHeight != UnknownObstacleHeight) continue;
+		const FCoverEdgeWork& edge = edges[point._edgeIdx];
+		point._obstacleHeight = traces.GetHit(point._traceIdx)._blockingHit ? GetHighestStandHeight(edge._profiles) : GetLowestCrouchHeight(edge._profiles);
+	}
+
+	for (const FCoverInternalPointWork& point : internalPoints)
+	{
+		if (!point._isValid) continue;
+
+		// only the profiles that can lean over the obstacle use the point
+		float obstacleHeight = point._obstacleHeight;
+		uint8 profileClasses[3];
+		ClassifyProfiles(edges[point._edgeIdx]._profiles, obstacleHeight, profileClasses);
+		if (profileClasses[1] == 0) continue;
+
+		bool canStand = false; // if agent can lean over, standing isn't safe
+		FVector dirToCover = -edges[point._edgeIdx]._faceNormal;
+		FVector leanDir = FVector::UpVector;
+
+		edges[point._edgeIdx]._points.Emplace(point._location, dirToCover, leanDir, canStand, obstacleHeight, profileClasses[1]);
+	}
+}
+
+
+void FCoverGenerationCore::BuildVisibilityCache(FCoverPointSet& coverPoints, const TArray<int32>& handles, int32 first, int32 num, TFunctionRef<bool()> isCancelled) const
+{
+	if (!coverPoints._visibility.IsInitialized()) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_VisibilityCache);
+
+	// points are cached in chunks, so the trace batch of a big generation does not grow too large
+	const int32 pointsPerBatch = 64;
+	const int32 numSamples = 4;
+
+	// cells the cover point was traced against and where their traces start in the batch
+	struct FVisibilityCellWork
+	{
+		int32 _handle;
+		int32 _windowCellIdx;
+		int32 _firstTrace;
+		int32 _numExposures;
+	};
+
+	TArray<FVisibilityCellWork> cells;
+	FCoverRaycastBatch traces;
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_VisibilityTraces);
+
+	for (int32 chunkStart = first; chunkStart < first + num; chunkStart += pointsPerBatch)
+	{
+		if (isCancelled()) return;
+
+		cells.Reset();
+		traces.Reset();
+
+		int32 chunkEnd = FMath::Min(chunkStart + pointsPerBatch, first + num);
+		for (int32 newIdx = chunkStart; newIdx < chunkEnd; newIdx++)
+		{
+			int32 handle = handles[newIdx];
+			FCoverPointData cp = coverPoints._store.Get(handle);
+
+			// the positions an agent exposes while using the cover point, the same ones the safety test traces from
+			FVector exposures[2];
+			int32 numExposures = 0;
+			if (cp.CanLeanSide())
+			{
+				FVector outerDir = FVector(cp._leanDirection.X, cp._leanDirection.Y, 0.0f) - FVector(cp._dirToCover.X, cp._dirToCover.Y, 0.0f);
+				exposures[numExposures++] = cp._location + outerDir.GetSafeNormal() * _params._coverPointOffset + FVector::UpVector * _params._crouchAttackHeight;
+			}
+			if (cp.CanLeanOver() || !cp.CanLeanSide())
+			{
+				exposures[numExposures++] = cp._location - cp._dirToCover * _params._coverPointOffset + FVector::UpVector * _params._standAttackHeight;
+			}
+
+			coverPoints._visibility.ForEachWindowCell(cp._location, [&](int32 windowCellIdx, const FBox& cellBounds)
+			{
+				cells.Add({ handle, windowCellIdx, traces.Num(), numExposures });
+
+				// samples are spread over the cell, a single sample would say little about the rest of the cell
+				const FVector center = cellBounds.GetCenter();
+				const float quarter = cellBounds.GetExtent().X * 0.5f;
+				const FVector samples[numSamples] = { center + FVector(-quarter, -quarter, 0.0f), center + FVector(quarter, -quarter, 0.0f),
+					center + FVector(-quarter, quarter, 0.0f), center + FVector(quarter, quarter, 0.0f) };
+
+				for (int32 exposureIdx = 0; exposureIdx < numExposures; exposureIdx++)
+				{
+					for (const FVector& sample : samples)
+					{
+						traces.Add(exposures[exposureIdx], sample);
+					}
+				}
+			});
+		}
+
+		traces.Execute(_raycaster);
+
+		for (const FVisibilityCellWork& cell : cells)
+		{
+			bool anyClear = false;
+			bool exposureFullyVisible = false;
+			for (int32 exposureIdx = 0; exposureIdx < cell._numExposures; exposureIdx++)
+			{
+				bool allClear = true;
+				for (int32 sampleIdx = 0; sampleIdx < numSamples; sampleIdx++)
+				{
+					bool clear = !traces.GetHit(cell._firstTrace + exposureIdx * numSamples + sampleIdx)._blockingHit;
+					anyClear |= clear;
+					allClear &= clear;
+				}
+				exposureFullyVisible |= allClear;
+			}
+
+			ECoverVisibility visibility = exposureFullyVisible ? ECoverVisibility::Visible : (anyClear ? ECoverVisibility::Mixed : ECoverVisibility::Hidden);
+			coverPoints._visibility.Set(cell._handle, cell._windowCellIdx, visibility);
+		}
+	}
+}
+
+void FCoverGenerationCore::BuildExposureSectors(FCoverPointSet& coverPoints, const TArray<int32>& handles, int32 first, int32 num, TFunctionRef<bool()> isCancelled) const
+{
+	FCoverExposureCache& exposure = coverPoints._exposure;
+	if (!exposure.IsInitialized()) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_ExposureSectors);
+
+	const int32 pointsPerBatch = 64;
+	const int32 numRays = FCoverExposureCache::NumSectors * FCoverExposureCache::RaysPerSector;
+	const int32 tracesPerPoint = FCoverExposureCache::NumHeights * numRays;
+	const float heights[FCoverExposureCache::NumHeights] = { _params._crouchAttackHeight, _params._standAttackHeight };
+
+	FVector rayDirections[numRays];
+	for (int32 rayIdx = 0; rayIdx < numRays; rayIdx++)
+	{
+		rayDirections[rayIdx] = FCoverExposureCache::GetRayDirection(rayIdx) * exposure.GetRange();
+	}
+
+	FCoverRaycastBatch traces;
+	SET_COVERGEN_TRACE_STAT(traces, STAT_CoverGen_ExposureTraces);
+
+	for (int32 chunkStart = first; chunkStart < first + num; chunkStart += pointsPerBatch)
+	{
+		if (isCancelled()) return;
+
+		// every point traces all rays at both heights, starting at traces[(newIdx - chunkStart) * tracesPerPoint]
+		traces.Reset();
+		int32 chunkEnd = FMath::Min(chunkStart + pointsPerBatch, first + num);
+		for (int32 newIdx = chunkStart; newIdx < chunkEnd; newIdx++)
+		{
+			const FVector location = coverPoints._store.GetLocation(handles[newIdx]);
+			for (float height : heights)
+			{
+				const FVector rayStart = location + FVector::UpVector * height;
+				for (const FVector& rayDirection : rayDirections)
+				{
+					traces.Add(rayStart, rayStart + rayDirection);
+				}
+			}
+		}
+
+		traces.Execute(_raycaster);
+
+		for (int32 newIdx = chunkStart; newIdx < chunkEnd; newIdx++)
+		{
+			int32 firstTrace = (newIdx - chunkStart) * tracesPerPoint;
+			for (int32 heightIdx = 0; heightIdx < FCoverExposureCache::NumHeights; heightIdx++)
+			{
+				int32 firstRay = firstTrace + heightIdx * numRays;
+				for (int32 sector = 0; sector < FCoverExposureCache::NumSectors; sector++)
+				{
+					// a sector is only as closed as its furthest hit, a ray that hits nothing opens it
+					float blockedDistance = 0.0f;
+					for (int32 sampleIdx = 0; sampleIdx <= FCoverExposureCache::RaysPerSector; sampleIdx++)
+					{
+						const FCoverRaycastHit& hit = traces.GetHit(firstRay + (sector * FCoverExposureCache::RaysPerSector + sampleIdx) % numRays);
+						if (!hit._blockingHit)
+						{
+							blockedDistance = -1.0f;
+							break;
+						}
+						blockedDistance = FMath::Max(blockedDistance, hit._distance);
+					}
+
+					exposure.Set(handles[newIdx], (ECoverExposureHeight)heightIdx, sector, blockedDistance);
+				}
+			}
+		}
+	}
+}
+
+
+/*
+---------- Tests ------------
+*/
+
+// Adds a horizontal trace towards the obstacle at the given height above the cover location. ProvidesCover requires it to hit the obstacle.
+int32 FCoverGenerationCore::AddObstacleHeightTrace(FCoverRaycastBatch& traces, const FVector& coverLocation, const FVector& coverFaceNormal, float height) const
+{
+	FVector checkStart = coverLocation;
+	checkStart.Z += height;
+	FVector checkStop = checkStart + -coverFaceNormal * _params._obstacleCheckDistance;
+
+	return traces.Add(checkStart, checkStop);
+}
+
+// Adds the height profile probe of a cover location: a downward trace just behind a point on the obstacle face, from above the highest
+//  height test down to the face point. CanStand and CanLeanOver are derived from the measured height instead of tracing each height.
+int32 FCoverGenerationCore::AddObstacleHeightProbe(FCoverRaycastBatch& traces, const FVector& facePoint, const FVector& coverFaceNormal, float groundZ) const
+{
+	FVector probeStop = facePoint + -coverFaceNormal.GetSafeNormal2D() * HeightProbeDepth;
+	FVector probeStart = probeStop;
+	probeStart.Z = groundZ + GetHeightProbeTop();
+
+	return traces.Add(probeStart, probeStop);
+}
+
+float FCoverGenerationCore::GetObstacleHeight(const FCoverRaycastBatch& traces, int32 traceIdx, float groundZ) const
+{
+	// a probe that starts inside the obstacle hits it right away: the obstacle is higher than the probe. A probe that misses went past
+	//  the obstacle (thinner than the probe depth, slanted or open face) and did not measure it.
+	const FCoverRaycastHit& probeHit = traces.GetHit(traceIdx);
+	if (!probeHit._blockingHit) return UnknownObstacleHeight;
+	if (probeHit._distance < KINDA_SMALL_NUMBER) return GetHeightProbeTop();
+
+	return probeHit._location.Z - groundZ;
+}
+
+float FCoverGenerationCore::GetHeightProbeTop() const
+{
+	float probeTop = 0.0f;
+	for (const FCoverProfileThresholds& profile : _params._profiles)
+	{
+		probeTop = FMath::Max(probeTop, FMath::Max3(profile._minCrouchCoverHeight, profile._minStandCoverHeight, profile._maxAttackOverEdgeHeight));
+	}
+
+	return probeTop + 1.0f;
+}
+
+// returns the profiles that do not have a cover point closer than the minimum distance to the position yet
+uint8 FCoverGenerationCore::GetProfilesWithoutCoverPoint(const FCoverPointSet& coverPoints, const FVector& position, uint8 profiles) const
+{
+	for (int32 profileIdx = 0; profileIdx < _params._profiles.Num(); profileIdx++)
+	{
+		const uint8 profileBit = 1 << profileIdx;
+		if ((profiles & profileBit) == 0) continue;
+
+		if (coverPoints._index->HasPointWithin(position, _params._coverPointMinDistance, coverPoints._store, profileBit)) profiles &= ~profileBit;
+	}
+
+	return profiles;
+}
+
+uint8 FCoverGenerationCore::GetProfilesWithoutCoverPoint(const FCoverPointSet& coverPoints, const FVector& position, uint8 profiles, const TArray<FCoverPointCandidate>& pendingPoints) const
+{
+	// points of the edge that is currently being generated are not in the index yet
+	for (const FCoverPointCandidate& candidate : pendingPoints)
+	{
+		if ((candidate._location - position).Size() < _params._coverPointMinDistance)
+		{
+			profiles &= ~candidate._profiles;
+		}
+	}
+
+	return profiles != 0 ? GetProfilesWithoutCoverPoint(coverPoints, position, profiles) : 0;
+}
+
+/*
+---------- Profiles ------------
+*/
+
+float FCoverGenerationCore::GetLowestCrouchHeight(uint8 profiles) const
+{
+	float height = MAX_flt;
+	for (int32 profileIdx = 0; profileIdx < _params._profiles.Num(); profileIdx++)
+	{
+		if (profiles & (1 << profileIdx)) height = FMath::Min(height, _params._profiles[profileIdx]._minCrouchCoverHeight);
+	}
+
+	return height;
+}
+
+float FCoverGenerationCore::GetHighestStandHeight(uint8 profiles) const
+{
+	float height = 0.0f;
+	for (int32 profileIdx = 0; profileIdx < _params._profiles.Num(); profileIdx++)
+	{
+		if (profiles & (1 << profileIdx)) height = FMath::Max(height, _params._profiles[profileIdx]._minStandCoverHeight);
+	}
+
+	return height;
+}
+
+// Splits the profiles by how they can use an obstacle of the given height: outProfiles[0] only crouch behind it, outProfiles[1] can
+//  lean over it and outProfiles[2] can stand behind it. Profiles the obstacle is too low for are left out.
+void FCoverGenerationCore::ClassifyProfiles(uint8 profiles, float obstacleHeight, uint8 (&outProfiles)[3]) const
+{
+	outProfiles[0] = outProfiles[1] = outProfiles[2] = 0;
+	for (int32 profileIdx = 0; profileIdx < _params._profiles.Num(); profileIdx++)
+	{
+		const uint8 profileBit = 1 << profileIdx;
+		const FCoverProfileThresholds& profile = _params._profiles[profileIdx];
+		if ((profiles & profileBit) == 0 || obstacleHeight < profile._minCrouchCoverHeight) continue;
+
+		if (obstacleHeight >= profile._minStandCoverHeight) outProfiles[2] |= profileBit;
+		else if (obstacleHeight < profile._maxAttackOverEdgeHeight) outProfiles[1] |= profileBit;
+		else outProfiles[0] |= profileBit;
+	}
+}
+
+/*
+---------- Helper methods ------------
+*/
+
+int32 FCoverGenerationCore::StoreNewCoverPoint(FCoverPointSet& coverPoints, const FCoverPointCandidate& candidate) const
+{
+	FCoverPointData cp;
+	cp.Init(candidate._location, candidate._dirToCover, candidate._leanDirection, candidate._canStand, candidate._obstacleHeight, candidate._profiles);
+	int32 handle = coverPoints._store.Add(cp._location, cp._dirToCover, cp._leanDirection, cp._flags, cp._obstacleHeight, cp._profiles);
+	coverPoints._index->Add(handle, cp._location);
+
+	return handle;
+}
+
+bool FCoverGenerationCore::InsideGenerationVolume(const FVector& point, const FBox& box) const
+{
+	return FMath::PointBoxIntersection(point, box);
+}
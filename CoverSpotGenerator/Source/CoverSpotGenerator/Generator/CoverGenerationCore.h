@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverDataStructures.h"
+#include "CoverGenerationJob.h"
+#include "CoverRaycaster.h"
+
+// height thresholds of one agent profile, see FCoverAgentProfile
+struct FCoverProfileThresholds
+{
+	float _minCrouchCoverHeight = 120.0f;
+	float _minStandCoverHeight = 180.0f;
+	float _maxAttackOverEdgeHeight = 140.0f;
+};
+
+// parameters of the cover point generation, see the generator's properties of the same name
+struct FCoverGenerationParams
+{
+	float _coverPointMinDistanceOnEdge = 150.0f;
+	float _coverPointMinDistance = 50.0f;
+	int32 _maxNumPointsPerEdge = 8;
+	float _coverPointOffset = 30.0f;
+	TArray<FCoverProfileThresholds> _profiles = { FCoverProfileThresholds() }; // profile i is bit i of the profile masks, at most MaxCoverAgentProfiles
+	float _standAttackHeight = 150.0f;
+	float _crouchAttackHeight = 100.0f;
+	float _sideLeanOffset = 50.0f;
+	float _obstacleCheckDistance = 100.0f;
+	float _obstacleSideCheckInterval = 10.0f;
+	int32 _numObstacleSideChecks = 10;
+	ECoverSideSearchMode _sideSearchMode = ECoverSideSearchMode::Linear;
+	float _sideSearchMaxDistance = 400.0f;
+	float _sideSearchTolerance = 2.0f;
+	bool _complexCanLeanOverObstacleTest = false;
+	float _maxProjectionHeight = 500.0f; // maximum distance a vertex is projected down to the ground
+};
+
+/**
+ * The cover point generation algorithm, independent of the engine's world and navigation system. It takes nav mesh edges and finds
+ * cover points along them with the line traces of a raycaster, every stage runs the traces of all edges as one batch. The generator
+ * actor feeds it with its navmesh and world, offline tools and benchmarks can run it on their own edges and geometry.
+ */
+class COVERSPOTGENERATOR_API FCoverGenerationCore
+{
+public:
+	FCoverGenerationCore(const FCoverGenerationParams& params, ICoverRaycaster& raycaster) : _params(params), _raycaster(raycaster) { }
+
+	// Merges chains of edges that continue each other in a straight line into one edge per wall segment. An edge only continues another
+	// if it starts where the other ends, no other edge meets them there and both have the same profiles. All vertices of a merged chain
+	// stay within maxDeviation of the segment. Vertices no longer used are removed. Returns the number of edges that were merged away.
+	static int32 MergeWallSegments(TArray<FVector>& vertices, TArray<FCoverNavEdge>& navEdges, float maxDeviation);
+
+	// projects the vertices [firstVertex, firstVertex + numVertices) down to the ground, vertices without ground below them are kept.
+	// isCancelled is polled between chunks of vertices.
+	void ProjectVertices(TArray<FVector>& vertices, int32 firstVertex, int32 numVertices, TFunctionRef<bool()> isCancelled) const;
+
+	// Generates the cover points of the edges [firstEdge, firstEdge + numEdges) that intersect the bbox and stores them in the set, appending
+	// their handles to outNewHandles. isCancelled is polled between the stages, a cancelled generation stops without storing points.
+	// All profiles of an edge share its traces, a location is stored once for every group of profiles that can use it in the same way.
+	void GenerateCoverPoints(const TArray<FVector>& vertices, const TArray<FCoverNavEdge>& navEdges, int32 firstEdge, int32 numEdges, const FBox& bbox,
+		FCoverPointSet& coverPoints, TArray<int32>& outNewHandles, TFunctionRef<bool()> isCancelled) const;
+
+	// caches the visibility of handles [first, first + num), only if the set's visibility cache is initialized
+	void BuildVisibilityCache(FCoverPointSet& coverPoints, const TArray<int32>& handles, int32 first, int32 num, TFunctionRef<bool()> isCancelled) const;
+
+	// measures the exposure sectors of handles [first, first + num), only if the set's exposure cache is initialized
+	void BuildExposureSectors(FCoverPointSet& coverPoints, const TArray<int32>& handles, int32 first, int32 num, TFunctionRef<bool()> isCancelled) const;
+
+	// Runs the obstacle face and side search stages only and appends the side points that were found, for tools and benchmarks.
+	// Returns the number of traces of the side search.
+	int64 SearchObstacleSides(const TArray<FVector>& vertices, const TArray<FCoverNavEdge>& navEdges, TArray<FVector>& outSidePoints) const;
+
+	FORCEINLINE const FCoverGenerationParams& GetParams() const { return _params; }
+
+private:
+	// Stages
+	void FindObstacleFaces(TArray<FCoverEdgeWork>& edges, FCoverRaycastBatch& traces) const;
+	void FindSideCoverPoints(TArray<FCoverEdgeWork>& edges, FCoverRaycastBatch& traces) const;
+	void ClassifySidePoints(TArray<FCoverEdgeWork>& edges, const FCoverPointSet& coverPoints, const FBox& bbox, FCoverRaycastBatch& traces) const;
+	void GenerateInternalPoints(TArray<FCoverEdgeWork>& edges, const FCoverPointSet& coverPoints, const FBox& bbox, FCoverRaycastBatch& traces) const;
+
+	// Tests
+	FORCEINLINE int32 AddObstacleHeightTrace(FCoverRaycastBatch& traces, const FVector& coverLocation, const FVector& coverFaceNormal, float height) const;
+	FORCEINLINE int32 AddObstacleHeightProbe(FCoverRaycastBatch& traces, const FVector& facePoint, const FVector& coverFaceNormal, float groundZ) const;
+	FORCEINLINE float GetObstacleHeight(const FCoverRaycastBatch& traces, int32 traceIdx, float groundZ) const; // negative if the probe missed
+	FORCEINLINE float GetHeightProbeTop() const; // obstacles are measured up to this height above the ground
+	FORCEINLINE uint8 GetProfilesWithoutCoverPoint(const FCoverPointSet& coverPoints, const FVector& position, uint8 profiles) const;
+	FORCEINLINE uint8 GetProfilesWithoutCoverPoint(const FCoverPointSet& coverPoints, const FVector& position, uint8 profiles, const TArray<FCoverPointCandidate>& pendingPoints) const;
+
+	// Profiles
+	float GetLowestCrouchHeight(uint8 profiles) const;
+	float GetHighestStandHeight(uint8 profiles) const;
+	void ClassifyProfiles(uint8 profiles, float obstacleHeight, uint8 (&outProfiles)[3]) const;
+
+	// Helper methods
+	int32 StoreNewCoverPoint(FCoverPointSet& coverPoints, const FCoverPointCandidate& candidate) const;
+	FORCEINLINE bool InsideGenerationVolume(const FVector& point, const FBox& box) const;
+
+	FCoverGenerationParams _params;
+	ICoverRaycaster& _raycaster;
+};
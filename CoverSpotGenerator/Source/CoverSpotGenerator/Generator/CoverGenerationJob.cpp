@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverGenerationJob.h"
+
+void FCoverPointSet::BuildIndex(ECoverPointIndexType type, const FBox& bounds, float elementExtent, float cellSize)
+{
+	_index = FCoverPointIndex::Create(type, bounds, elementExtent, cellSize);
+	_store.ForEachHandle([this](int32 handle)
+	{
+		_index->Add(handle, _store.GetLocation(handle));
+	});
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverDataStructures.h"
+#include "CoverPointStore.h"
+#include "CoverPointIndex.h"
+#include "CoverVisibilityCache.h"
+#include "CoverExposureCache.h"
+
+// A complete set of cover points and its spatial index. Queries read the published set, generation fills another set and publishes it when done.
+struct FCoverPointSet
+{
+	FCoverPointStore _store;
+	TUniquePtr<FCoverPointIndex> _index;
+	FCoverVisibilityCache _visibility; // optional, only built when the generator is asked to
+	FCoverExposureCache _exposure; // optional as well
+
+	// (re)creates the index and adds all stored points to it
+	void BuildIndex(ECoverPointIndexType type, const FBox& bounds, float elementExtent, float cellSize);
+};
+
+typedef TSharedPtr<FCoverPointSet, ESPMode::ThreadSafe> FCoverPointSetPtr;
+
+// A single generation request and all data it works on. A superseded job can finish its current stage without touching the data of newer jobs.
+struct FCoverGenerationJob
+{
+	FCoverGenerationJob(const FBox& bbox, bool incremental, int32 serial) : _bbox(bbox), _incremental(incremental), _serial(serial) { }
+
+	FBox _bbox;
+	bool _incremental;
+	int32 _serial; // the job is cancelled once the generator's serial moved on
+	bool _succeeded = false;
+
+	FCoverPointSetPtr _coverPoints; // set the job writes to
+
+	// nav mesh data: boundary edges that may intersect the generation bbox and their unique, ground projected vertices
+	TArray<FVector> _navVertices;
+	TArray<FCoverNavEdge> _navEdges;
+
+	// cover points added by this job, their visibility still has to be cached
+	TArray<int32> _newHandles;
+
+	// progress of a time-sliced job: vertices are projected first, then the edges are generated and the visibility of the new points is cached
+	int32 _nextVertex = 0;
+	int32 _nextEdge = 0;
+	int32 _nextNewHandle = 0;
+};
+
+typedef TSharedPtr<FCoverGenerationJob, ESPMode::ThreadSafe> FCoverGenerationJobPtr;
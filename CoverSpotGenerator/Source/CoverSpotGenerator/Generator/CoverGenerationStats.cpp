@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverGenerationStats.h"
+
+DEFINE_STAT(STAT_CoverGen_Total);
+DEFINE_STAT(STAT_CoverGen_EdgeExtraction);
+DEFINE_STAT(STAT_CoverGen_GroundProjection);
+DEFINE_STAT(STAT_CoverGen_FaceNormal);
+DEFINE_STAT(STAT_CoverGen_SideSweep);
+DEFINE_STAT(STAT_CoverGen_SideClassification);
+DEFINE_STAT(STAT_CoverGen_InternalPoints);
+DEFINE_STAT(STAT_CoverGen_IndexInsert);
+DEFINE_STAT(STAT_CoverGen_VisibilityCache);
+DEFINE_STAT(STAT_CoverGen_ExposureSectors);
+
+DEFINE_STAT(STAT_CoverGen_GroundProjectionTraces);
+DEFINE_STAT(STAT_CoverGen_FaceNormalTraces);
+DEFINE_STAT(STAT_CoverGen_SideSweepTraces);
+DEFINE_STAT(STAT_CoverGen_SideClassificationTraces);
+DEFINE_STAT(STAT_CoverGen_InternalPointTraces);
+DEFINE_STAT(STAT_CoverGen_VisibilityTraces);
+DEFINE_STAT(STAT_CoverGen_ExposureTraces);
+
+DEFINE_STAT(STAT_CoverGen_EdgesAccepted);
+DEFINE_STAT(STAT_CoverGen_EdgesCulled);
+DEFINE_STAT(STAT_CoverGen_EdgesWithoutObstacle);
+DEFINE_STAT(STAT_CoverGen_EdgesMerged);
+DEFINE_STAT(STAT_CoverGen_PointsProduced);
+DEFINE_STAT(STAT_CoverGen_PointsDeduplicated);
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// "stat CoverGen" shows the time spent in every generation stage and the work it did. The counters accumulate over all generations
+// since the start, so they also cover async jobs that finish between two frames.
+DECLARE_STATS_GROUP(TEXT("CoverGen"), STATGROUP_CoverGen, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Total generation"), STAT_CoverGen_Total, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Edge extraction"), STAT_CoverGen_EdgeExtraction, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ground projection"), STAT_CoverGen_GroundProjection, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Face normal"), STAT_CoverGen_FaceNormal, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Side sweep"), STAT_CoverGen_SideSweep, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Side classification"), STAT_CoverGen_SideClassification, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Internal points"), STAT_CoverGen_InternalPoints, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Index insert"), STAT_CoverGen_IndexInsert, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Visibility cache"), STAT_CoverGen_VisibilityCache, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Exposure sectors"), STAT_CoverGen_ExposureSectors, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ground projection traces"), STAT_CoverGen_GroundProjectionTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Face normal traces"), STAT_CoverGen_FaceNormalTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Side sweep traces"), STAT_CoverGen_SideSweepTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Side classification traces"), STAT_CoverGen_SideClassificationTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Internal point traces"), STAT_CoverGen_InternalPointTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Visibility traces"), STAT_CoverGen_VisibilityTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Exposure traces"), STAT_CoverGen_ExposureTraces, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Edges accepted"), STAT_CoverGen_EdgesAccepted, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Edges culled"), STAT_CoverGen_EdgesCulled, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Edges without obstacle"), STAT_CoverGen_EdgesWithoutObstacle, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Edges merged into wall segments"), STAT_CoverGen_EdgesMerged, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Points produced"), STAT_CoverGen_PointsProduced, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Points deduplicated"), STAT_CoverGen_PointsDeduplicated, STATGROUP_CoverGen, COVERSPOTGENERATOR_API);
+
+// makes the batch add the number of traces it executes to the given accumulator
+#if STATS
+#define SET_COVERGEN_TRACE_STAT(Traces, Stat) (Traces).SetTraceStat(GET_STATFNAME(Stat))
+#else
+#define SET_COVERGEN_TRACE_STAT(Traces, Stat)
+#endif
@@ -9,30 +9,92 @@
 #include "NavigationSystem.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/LevelBounds.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "EngineUtils.h"
 #include "Engine/Engine.h"
 #include "Async/AsyncWork.h"
 #include "CoverSpotGeneratorAsync.h"
+#include "CoverBakeData.h"
+#include "CoverGenerationStats.h"
+#include "CoverWorldRaycaster.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
 
 #define EPSILON 0.00001
 
+static const float MaxNavProjectionHeight = 500.0f; // maximum distance a nav mesh vertex is projected down to the ground
+
 // Sets default values
 ACoverPointGenerator::ACoverPointGenerator()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
-	_isInitialized = false;
 	_needsRedrawing = true;
+	_generationInProgress = false;
+	_dirtyNavBoundsAge = 0.0f;
+	_runningJobBBox = FBox(ForceInit);
+	_runningJobIncremental = false;
+}
+
+void ACoverPointGenerator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (_regenerateOnNavMeshUpdate)
+	{
+		_navigationDirtyHandle = UNavigationSystemV1::NavigationDirtyEvent.AddUObject(this, &ACoverPointGenerator::OnNavigationDirty);
+	}
+
+	if (_loadBakedCoverData)
+	{
+		LoadBakedCoverData();
+	}
+}
+
+void ACoverPointGenerator::EndPlay(const EEndPlayReason::Type endPlayReason)
+{
+	UNavigationSystemV1::NavigationDirtyEvent.Remove(_navigationDirtyHandle);
+	_dirtyNavBounds.Empty();
+	_pendingRegions.Empty();
+	CancelGenerationJobs();
+
+	// async jobs still reference this generator, wait until they reached their next cancellation point. Every stage of a job polls
+	// for cancellation at least per nav mesh tile or per chunk of traces, so this takes about one chunk.
+	while (_numRunningJobs.GetValue() > 0)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	Super::EndPlay(endPlayReason);
 }
 
 void ACoverPointGenerator::Tick(float dt)
 {
+	PublishFinishedJob();
+
+	if (_timeSlicedJob.IsValid())
+	{
+		AdvanceTimeSlicedGeneration();
+	}
+
 	// poll if debug visualization needs to be redrawn
-	if (_asyncGeneration && _needsRedrawing)
+	if ((_asyncGeneration || _timeSlicedGeneration) && _needsRedrawing)
 	{
 		DrawDebugData();
 	}
+
+	// wait until the navmesh is done rebuilding and no new dirty areas came in for a while
+	if (_dirtyNavBounds.Num() > 0)
+	{
+		_dirtyNavBoundsAge += dt;
+
+		UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+		if (_dirtyNavBoundsAge >= _navMeshUpdateBatchTime && navSystem && !navSystem->IsNavigationBuildInProgress())
+		{
+			FlushDirtyNavMeshTiles();
+		}
+	}
+
+	ProcessPendingRegions();
 }
 
 
@@ -53,20 +115,12 @@ ACoverPointGenerator* ACoverPointGenerator::Get(UWorld* world)
 
 void ACoverPointGenerator::UpdateCoverpointData(const FBox& bbox)
 {
-	_isInitialized = false;
+	RequestGeneration(bbox, false);
+}
 
-	if (_asyncGeneration)
-	{
-		UWorld* world = GetWorld();
-		ACoverPointGenerator* cpg = ACoverPointGenerator::Get(world);
-		FAutoDeleteAsyncTask<CoverSpotGeneratorAsync>* task = new FAutoDeleteAsyncTask<CoverSpotGeneratorAsync>(cpg, bbox);
-		task->StartBackgroundTask();
-	}
-	else
-	{
-		_Initialize(bbox);
-		DrawDebugData();
-	}
+void ACoverPointGenerator::UpdateCoverpointDataInRegion(const FBox& bbox)
+{
+	RequestGeneration(bbox, true);
 }
 
 void ACoverPointGenerator::ClearCoverpointData()
@@ -74,73 +128,193 @@ void ACoverPointGenerator::ClearCoverpointData()
 	ResetCoverPointData();
 }
 
-TArray<UCoverPoint*> ACoverPointGenerator::GetCoverPointsWithinExtent(const FVector& position, float extent) const
+TArray<FCoverPointData> ACoverPointGenerator::GetCoverPointsWithinExtent(const FVector& position, float extent) const
 {
-	if (!_isInitialized) return TArray<UCoverPoint*>();
+	// hold a reference, so the set stays alive even if a new one is published in the meantime
+	FCoverPointSetPtr coverPoints = _coverPointSet;
+	if (!coverPoints.IsValid() || !coverPoints->_index.IsValid()) return TArray<FCoverPointData>();
 
 	FBox bbox(position - FVector(extent), position + FVector(extent));
-	TArray<UCoverPoint*> points;
+	TArray<FCoverPointData> points;
+
+	TArray<int32> handles;
+	coverPoints->_index->QueryBox(bbox, coverPoints->_store, handles);
 
-	// iterate over the octree to find cover points within the given BBOX
-	for (TCoverPointOctree::TConstElementBoxIterator<> it(*_coverPoints, bbox); it.HasPendingElements(); it.Advance())
+	points.Reserve(handles.Num());
+	for (int32 handle : handles)
 	{
-		if (IsValid(it.GetCurrentElement()._coverPoint))
-		{
-			points.Emplace(it.GetCurrentElement()._coverPoint);
-		}
+		points.Emplace(coverPoints->_store.Get(handle));
 	}
 
 	return points;
 }
 
-// returns how many obstacles are in between the cover point and a given target location
-int ACoverPointGenerator::GetNumberOfIntersectionsFromCover(const UCoverPoint* cp, const FVector& targetLocation) const
+bool ACoverPointGenerator::GetCoverPoint(int32 handle, FCoverPointData& outPoint) const
 {
-	if (!_isInitialized) return 0;
+	FCoverPointSetPtr coverPoints = _coverPointSet;
+	if (!coverPoints.IsValid() || !coverPoints->_store.IsValidHandle(handle)) return false;
+
+	outPoint = coverPoints->_store.Get(handle);
+	return true;
+}
+
+FCoverPointSetPtr ACoverPointGenerator::GetCoverPointsInBoxes(TArrayView<const FBox> boxes, FCoverPointQueryBuffer& buffer) const
+{
+	buffer._handles.Reset();
+
+	FCoverPointSetPtr coverPoints = _coverPointSet;
+	if (!coverPoints.IsValid() || !coverPoints->_index.IsValid()) return nullptr;
+
+	coverPoints->_index->QueryBoxes(boxes, coverPoints->_store, buffer);
+	return coverPoints;
+}
+
+FCoverPointSetPtr ACoverPointGenerator::GetCoverPointsInSpheres(TArrayView<const FSphere> spheres, FCoverPointQueryBuffer& buffer) const
+{
+	TArray<FBox, TInlineAllocator<16>> boxes;
+	for (const FSphere& sphere : spheres)
+	{
+		boxes.Emplace(sphere.Center - FVector(sphere.W), sphere.Center + FVector(sphere.W));
+	}
+
+	FCoverPointSetPtr coverPoints = GetCoverPointsInBoxes(boxes, buffer);
+	if (!coverPoints.IsValid()) return nullptr;
+
+	// the index is queried with the bounding boxes, drop the points that are in the corners of all of them
+	buffer._handles.RemoveAll([&](int32 handle)
+	{
+		FVector location = coverPoints->_store.GetLocation(handle);
+		for (const FSphere& sphere : spheres)
+		{
+			if (FVector::DistSquared(location, sphere.Center) <= FMath::Square(sphere.W)) return false;
+		}
+		return true;
+	});
+
+	return coverPoints;
+}
+
+UCoverPoint* ACoverPointGenerator::CreateCoverPointObject(int32 handle)
+{
+	FCoverPointData data;
+	if (!GetCoverPoint(handle, data)) return nullptr;
+
+	UCoverPoint* cp = NewObject<UCoverPoint>(this);
+	cp->Init(data);
+
+	return cp;
+}
+
+int ACoverPointGenerator::GetNumberOfIntersectionsFromCover(const FCoverPointData& cp, const FVector& targetLocation, int32 maxCount, bool useVisibilityCache) const
+{
+	if (!_coverPointSet.IsValid()) return 0;
+
+	// an exposed position that is seen from the whole cell has nothing in between
+	if (useVisibilityCache && GetCachedVisibility(cp, targetLocation) == ECoverVisibility::Visible) return 0;
 
 	const int infinite = 0xffff;
-	const float epsilon = 0.00001f;
 	const float enemyCrouchHeight = 80.0f;
-	const FVector& leanDir = cp->_leanDirection;
+	const FVector& leanDir = cp._leanDirection;
 
-	int numHitsSide, numHitsOver = infinite;
+	int numHitsSide = infinite;
+	int numHitsOver = infinite;
 
 	UWorld* world = GetWorld();
 	if (!IsValid(world)) return infinite;
 
+	FVector traceEnd = targetLocation;
+	traceEnd.Z += enemyCrouchHeight;
+
 	// check number of intersections if agent would lean over this cover point obstacle
-	if (CanLeanOver(cp))
+	if (cp.CanLeanOver())
 	{
-		FVector traceStart = cp->_location;
+		FVector traceStart = cp._location;
 		traceStart.Z += _standAttackHeight;
 
-		FVector traceEnd = targetLocation;
-		traceEnd.Z += enemyCrouchHeight;
+		numHitsOver = FCoverWorldRaycaster::CountHits(world, traceStart, traceEnd, maxCount);
 
-		TArray<FHitResult> outHits;
-		UKismetSystemLibrary::LineTraceMulti(world, traceStart, traceEnd, ETraceTypeQuery::TraceTypeQuery1, false, TArray<AActor*>(), EDrawDebugTrace::None, outHits, true);
-
-		numHitsOver = outHits.Num();
+		// the side can not do better than a free line of sight
+		if (numHitsOver == 0) return 0;
 	}
 
-	// check number of intersections if agent would lean aside from this cover point obstacle
-	if (CanLeanSide(cp))
+	// check number of intersections if agent would lean aside from this cover point obstacle, only fewer hits than leaning over matter
+	if (cp.CanLeanSide())
 	{
-		FVector traceStart = cp->_location;
+		FVector traceStart = cp._location;
 		traceStart.Z += _crouchAttackHeight;
 		traceStart.X += leanDir.X;
 		traceStart.Y += leanDir.Y;
 
-		FVector traceEnd = targetLocation;
-		traceEnd.Z += enemyCrouchHeight;
+		numHitsSide = FCoverWorldRaycaster::CountHits(world, traceStart, traceEnd, FMath::Min(maxCount, numHitsOver));
+	}
 
-		TArray<FHitResult> outHits;
-		UKismetSystemLibrary::LineTraceMulti(world, traceStart, traceEnd, ETraceTypeQuery::TraceTypeQuery1, false, TArray<AActor*>(), EDrawDebugTrace::None, outHits, true);
+	return FMath::Min(numHitsSide, numHitsOver);
+}
+
+int32 ACoverPointGenerator::AddIntersectionTraces(const FCoverPointData& cp, const FVector& targetLocation, FCoverRaycastBatch& traces, bool useVisibilityCache) const
+{
+	if (useVisibilityCache && GetCachedVisibility(cp, targetLocation) == ECoverVisibility::Visible) return INDEX_NONE;
+
+	const float enemyCrouchHeight = 80.0f;
+	const FVector traceEnd = targetLocation + FVector::UpVector * enemyCrouchHeight;
+	int32 firstTrace = traces.Num();
 
-		numHitsSide = outHits.Num();
+	// same traces as GetNumberOfIntersectionsFromCover: leaning over first, then leaning aside
+	if (cp.CanLeanOver())
+	{
+		traces.Add(cp._location + FVector::UpVector * _standAttackHeight, traceEnd);
 	}
 
-	return FMath::Min(numHitsSide, numHitsOver);
+	if (cp.CanLeanSide())
+	{
+		FVector traceStart = cp._location;
+		traceStart.Z += _crouchAttackHeight;
+		traceStart.X += cp._leanDirection.X;
+		traceStart.Y += cp._leanDirection.Y;
+		traces.Add(traceStart, traceEnd);
+	}
+
+	return firstTrace;
+}
+
+int ACoverPointGenerator::GetNumberOfIntersections(const FCoverPointData& cp, const FCoverRaycastBatch& traces, int32 firstTrace) const
+{
+	const int infinite = 0xffff;
+	if (firstTrace == INDEX_NONE) return 0;
+
+	int numHits = infinite;
+	int32 traceIdx = firstTrace;
+	if (cp.CanLeanOver()) numHits = FMath::Min(numHits, traces.GetNumHits(traceIdx++));
+	if (cp.CanLeanSide()) numHits = FMath::Min(numHits, traces.GetNumHits(traceIdx++));
+
+	return numHits;
+}
+
+ECoverVisibility ACoverPointGenerator::GetCachedVisibility(const FCoverPointData& cp, const FVector& location) const
+{
+	if (!_coverPointSet.IsValid()) return ECoverVisibility::Unknown;
+
+	// the handle may refer to a set that has been replaced since, it then points to another location or to nothing
+	const FCoverPointSet& coverPoints = *_coverPointSet;
+	if (!coverPoints._store.IsValidHandle(cp._handle) || coverPoints._store.GetLocation(cp._handle) != cp._location) return ECoverVisibility::Unknown;
+
+	return coverPoints._visibility.Get(cp._handle, cp._location, location);
+}
+
+ECoverVisibility ACoverPointGenerator::GetCachedExposure(const FCoverPointData& cp, const FVector& location, ECoverExposureHeight height) const
+{
+	if (!_coverPointSet.IsValid()) return ECoverVisibility::Unknown;
+
+	const FCoverPointSet& coverPoints = *_coverPointSet;
+	if (!coverPoints._store.IsValidHandle(cp._handle) || coverPoints._store.GetLocation(cp._handle) != cp._location) return ECoverVisibility::Unknown;
+
+	return coverPoints._exposure.Get(cp._handle, cp._location, location, height);
+}
+
+ECoverExposureHeight ACoverPointGenerator::GetExposureHeight(float height) const
+{
+	// the sectors are measured at the attack heights, see FCoverGenerationCore::BuildExposureSectors
+	return FMath::Abs(height - _crouchAttackHeight) <= FMath::Abs(height - _standAttackHeight) ? ECoverExposureHeight::Crouch : ECoverExposureHeight::Stand;
 }
 
 
@@ -148,8 +322,63 @@ int ACoverPointGenerator::GetNumberOfIntersectionsFromCover(const UCoverPoint* c
 ---------- Management ------------
 */
 
-void ACoverPointGenerator::_Initialize(const FBox& bbox)
+void ACoverPointGenerator::RequestGeneration(const FBox& bbox, bool incremental)
+{
+	// a running job is only superseded by a request that regenerates everything the running job would, other regions wait for it
+	if (_generationInProgress && incremental && !(_runningJobIncremental && bbox.IsInside(_runningJobBBox)))
+	{
+		_pendingRegions.Emplace(bbox);
+		return;
+	}
+
+	FCoverGenerationJobPtr job = CreateGenerationJob(bbox, incremental);
+
+	// build a new set next to the published one, incremental jobs start from a copy of the published points. Queries keep using the
+	// previous complete set until the job publishes, for time-sliced jobs as well.
+	job->_coverPoints = MakeShared<FCoverPointSet, ESPMode::ThreadSafe>();
+	if (incremental && _coverPointSet.IsValid())
+	{
+		job->_coverPoints->_store = _coverPointSet->_store;
+		job->_coverPoints->_visibility = _coverPointSet->_visibility;
+		job->_coverPoints->_exposure = _coverPointSet->_exposure;
+	}
+
+	if (_timeSlicedGeneration)
+	{
+		StartTimeSlicedGeneration(job);
+		return;
+	}
+
+	if (_asyncGeneration)
+	{
+		_numRunningJobs.Increment();
+		FAutoDeleteAsyncTask<CoverSpotGeneratorAsync>* task = new FAutoDeleteAsyncTask<CoverSpotGeneratorAsync>(this, job);
+		task->StartBackgroundTask();
+	}
+	else
+	{
+		_Initialize(*job);
+		CompleteGenerationJob(job);
+		PublishFinishedJob();
+		DrawDebugData();
+	}
+}
+
+FCoverGenerationJobPtr ACoverPointGenerator::CreateGenerationJob(const FBox& bbox, bool incremental)
+{
+	// the new serial cancels all jobs that are still running
+	_timeSlicedJob.Reset();
+	_runningJobBBox = bbox;
+	_runningJobIncremental = incremental;
+	_generationInProgress = true;
+
+	return MakeShared<FCoverGenerationJob, ESPMode::ThreadSafe>(bbox, incremental, _generationSerial.Increment());
+}
+
+void ACoverPointGenerator::_Initialize(FCoverGenerationJob& job) const
 {
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_Total);
+
 	FDateTime totalTimeBefore, totalTimeAfter;
 	totalTimeBefore = FDateTime::Now();
 	FDateTime timeBefore, timeAfter;
@@ -158,17 +387,16 @@ void ACoverPointGenerator::_Initialize(const FBox& bbox)
 	UWorld* world = GetWorld();
 	if (world)
 	{
-		UNavigationSystemBase* navSystem = world->GetNavigationSystem();
-		if (navSystem)
+		timeBefore = FDateTime::Now();
+		TArray<FVector> edgeVertices;
+		TArray<uint8> edgeProfiles;
+		// a cancelled job stops at the next tile or chunk of vertices, EndPlay waits for it
+		if (GatherProfileNavMeshEdges(job._bbox, edgeVertices, edgeProfiles, [&]() { return IsJobSuperseded(job); }))
 		{
-			timeBefore = FDateTime::Now();
-			ARecastNavMesh* navMeshData = static_cast<ARecastNavMesh*>(FNavigationSystem::GetCurrent<UNavigationSystemV1>(world)->GetDefaultNavDataInstance());
-			FRecastDebugGeometry debugGeo;
-			debugGeo.bGatherNavMeshEdges = true;
-			navMeshData->BeginBatchQuery();
-			navMeshData->GetDebugGeometry(debugGeo);
-			navMeshData->FinishBatchQuery();
-			_navGeo = debugGeo;
+			if (IsJobSuperseded(job)) return;
+			BuildNavEdgeTable(job, edgeVertices, edgeProfiles);
+			if (IsJobSuperseded(job)) return;
+			ProjectNavVertices(world, job, 0, job._navVertices.Num());
 
 			timeAfter = FDateTime::Now();
 
@@ -187,9 +415,11 @@ void ACoverPointGenerator::_Initialize(const FBox& bbox)
 		return;
 	}
 
+	if (IsJobSuperseded(job)) return;
+
 	timeBefore = FDateTime::Now();
 	// init cover point data
-	_UpdateCoverPointData(bbox);
+	_UpdateCoverPointData(job);
 	timeAfter = FDateTime::Now();
 
 	timeTaken = (timeAfter - timeBefore).GetTotalSeconds();
@@ -200,338 +430,599 @@ void ACoverPointGenerator::_Initialize(const FBox& bbox)
 	UE_LOG(LogTemp, Log, TEXT("total time taken: %f"), totalTimeTaken);
 }
 
-void ACoverPointGenerator::_UpdateCoverPointData(const FBox& bbox)
+void ACoverPointGenerator::GatherNavMeshEdges(const ARecastNavMesh* navMeshData, const FBox& bbox, TArray<FVector>& outEdgeVertices,
+	TFunctionRef<bool()> isCancelled) const
 {
-	ResetCoverPointData();
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_EdgeExtraction);
 
-	// re-init octree
-	_coverPoints = MakeUnique<TCoverPointOctree>(bbox.GetCenter(), bbox.GetExtent().GetMax());
+	outEdgeVertices.Reset();
 
-	UWorld* world = GetWorld();
-	// loop over all nav mesh edges
-	int numEdges = _navGeo.NavMeshEdges.Num();
-	UE_LOG(LogTemp, Log, TEXT("Number of navmesh edges: %d"), numEdges);
-	for (int i = 0; i < numEdges; i += 2)
+	// only query the tiles overlapping the bbox. Nav points are projected down to the ground later on, so tiles slightly above the bbox are needed as well.
+	TArray<FBox> queryBounds;
+	queryBounds.Emplace(bbox.Min, bbox.Max + FVector(0.0f, 0.0f, MaxNavProjectionHeight));
+
+	TArray<int32> tileIndices;
+	navMeshData->GetNavMeshTilesIn(queryBounds, tileIndices);
+
+	navMeshData->BeginBatchQuery();
+	for (int32 tileIdx : tileIndices)
 	{
-		FVector v1 = _navGeo.NavMeshEdges[i];
-		FVector v2 = _navGeo.NavMeshEdges[i + 1];
-		ProjectNavPointsToGround(world, v1, v2);
+		if (isCancelled()) break;
+
+		FRecastDebugGeometry tileGeo;
+		tileGeo.bGatherNavMeshEdges = true;
+		navMeshData->GetDebugGeometry(tileGeo, tileIdx);
+
+		// only the boundary edges are kept, the tile's polygon data is thrown away right away
+		outEdgeVertices.Append(tileGeo.NavMeshEdges);
+	}
+	navMeshData->FinishBatchQuery();
+}
+
+bool ACoverPointGenerator::GatherProfileNavMeshEdges(const FBox& bbox, TArray<FVector>& outEdgeVertices, TArray<uint8>& outEdgeProfiles) const
+{
+	return GatherProfileNavMeshEdges(bbox, outEdgeVertices, outEdgeProfiles, []() { return false; });
+}
+
+bool ACoverPointGenerator::GatherProfileNavMeshEdges(const FBox& bbox, TArray<FVector>& outEdgeVertices, TArray<uint8>& outEdgeProfiles,
+	TFunctionRef<bool()> isCancelled) const
+{
+	TArray<TPair<const ARecastNavMesh*, uint8>> navMeshes;
+	GetProfileNavMeshes(navMeshes);
+
+	outEdgeVertices.Reset();
+	outEdgeProfiles.Reset();
+	TArray<FVector> navMeshEdgeVertices;
+	for (const TPair<const ARecastNavMesh*, uint8>& navMesh : navMeshes)
+	{
+		GatherNavMeshEdges(navMesh.Key, bbox, navMeshEdgeVertices, isCancelled);
+		outEdgeVertices.Append(navMeshEdgeVertices);
+		outEdgeProfiles.Add(navMesh.Value, navMeshEdgeVertices.Num() / 2);
+	}
+
+	return navMeshes.Num() > 0;
+}
+
+void ACoverPointGenerator::BuildNavEdgeTable(FCoverGenerationJob& job, const TArray<FVector>& edgeVertices, const TArray<uint8>& edgeProfiles) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CoverGen_EdgeExtraction);
+
+	TArray<FVector>& navVertices = job._navVertices;
+	TArray<FCoverNavEdge>& navEdges = job._navEdges;
+	const FBox& bbox = job._bbox;
+	navVertices.Reset();
+	navEdges.Reset();
 
-		if (!FMath::LineBoxIntersection(bbox, v1, v2, (v2 - v1))) continue;
+	// vertices only move down when projected to the ground, so an edge that misses the bbox extended upwards can never intersect the bbox itself
+	FBox cullBox(bbox.Min, bbox.Max + FVector(0.0f, 0.0f, MaxNavProjectionHeight));
 
-		// calculate edge
-		FVector edgeDir = (v2 - v1);
-		float edgeLength = edgeDir.Size();	
-		edgeDir /= edgeLength;
+	// vertices are shared by adjacent edges: store each of them only once
+	TMap<FVector, int32> vertexLookup;
+	auto findOrAddVertex = [&](const FVector& vertex) -> int32
+	{
+		if (const int32* idx = vertexLookup.Find(vertex)) return *idx;
+		return vertexLookup.Add(vertex, navVertices.Add(vertex));
+	};
 
-		// get the normal of the face of the obstacle that this edge is parallel to
-		FHitResult obstacleCheckHit;
-		if (!GetObstacleFaceNormal(world, v1, edgeDir, edgeLength, obstacleCheckHit)) continue;
+	// the nav meshes of different profiles share most of their boundary: an edge found in several of them is generated once, for all their profiles
+	TMap<TPair<int32, int32>, int32> edgeLookup;
 
-		FVector outLeftSide, outRightSide;
-		GenerateSidePoints(world, v2, v1, edgeDir, obstacleCheckHit.ImpactNormal, bbox, outLeftSide, outRightSide);
+	for (int i = 0; i + 1 < edgeVertices.Num(); i += 2)
+	{
+		const FVector& v1 = edgeVertices[i];
+		const FVector& v2 = edgeVertices[i + 1];
+		if (!FMath::LineBoxIntersection(cullBox, v1, v2, (v2 - v1))) continue;
 
-		// if not "complex can lean over obstacle test", check if agent can lean over obstacle once at middle of edge (may be too coarse)
-		if (!_complexCanLeanOverObstacleTest)
+		TPair<int32, int32> vertexPair(findOrAddVertex(v1), findOrAddVertex(v2));
+		if (const int32* edgeIdx = edgeLookup.Find(vertexPair))
 		{
-			bool isStandingCover = CanStand(world, v1 + edgeDir * edgeLength * 0.5f, obstacleCheckHit.Normal);
-			if (isStandingCover) continue;
+			navEdges[*edgeIdx]._profiles |= edgeProfiles[i / 2];
+			continue;
 		}
 
-		bool hasLeftSidePoint = !outLeftSide.Equals(v2);
-		bool hasRightSidePoint = !outRightSide.Equals(v1);
-		GenerateInternalPoints(world, outLeftSide, outRightSide, obstacleCheckHit.Normal, bbox, hasLeftSidePoint, hasRightSidePoint);
+		edgeLookup.Add(vertexPair, navEdges.Emplace(vertexPair.Key, vertexPair.Value, edgeProfiles[i / 2]));
 	}
 
-	int numCoverPoints = _coverPointBuffer.Num();
-	UE_LOG(LogTemp, Log, TEXT("Num cover points: %d"), numCoverPoints);
+	const int32 numCulledEdges = navEdges.Num();
+	INC_DWORD_STAT_BY(STAT_CoverGen_EdgesCulled, edgeVertices.Num() / 2 - numCulledEdges);
 
-	// apply octree optimization
-	_coverPoints->ShrinkElements();
+	if (_mergeWallSegments)
+	{
+		INC_DWORD_STAT_BY(STAT_CoverGen_EdgesMerged, FCoverGenerationCore::MergeWallSegments(navVertices, navEdges, _wallSegmentMaxDeviation));
+	}
 
-	_isInitialized = true;
-	_needsRedrawing = true;
+	UE_LOG(LogTemp, Log, TEXT("Nav edges: %d gathered, %d after culling, %d wall segments, %d unique vertices"), edgeVertices.Num() / 2, numCulledEdges,
+		navEdges.Num(), navVertices.Num());
 }
 
-void ACoverPointGenerator::ResetCoverPointData()
+void ACoverPointGenerator::_UpdateCoverPointData(FCoverGenerationJob& job) const
 {
-	_isInitialized = false;
+	BeginCoverPointUpdate(job);
 
-	_coverPointBuffer.Empty();
-	if(_coverPoints)
-		_coverPoints->Destroy();
-}
+	// edges are generated in chunks, so a cancelled job does not run the stages of a big area to the end
+	const int32 edgesPerBatch = 256;
 
+	UWorld* world = GetWorld();
+	for (int32 firstEdge = 0; firstEdge < job._navEdges.Num() && !IsJobSuperseded(job); firstEdge += edgesPerBatch)
+	{
+		GenerateCoverPoints(world, job, firstEdge, FMath::Min(edgesPerBatch, job._navEdges.Num() - firstEdge));
+	}
+	BuildVisibilityCache(world, job, 0, job._newHandles.Num());
 
-/*
----------- Generation ------------
-*/
+	EndCoverPointUpdate(job);
+}
 
-void ACoverPointGenerator::GenerateInternalPoints(UWorld* world, const FVector& leftPoint, const FVector& rightPoint, const FVector& obstNormal, const FBox& bbox, bool hasLeftSidePoint, bool hasRightSidePoint)
+void ACoverPointGenerator::BeginCoverPointUpdate(FCoverGenerationJob& job) const
 {
-	// get the edge between the two side cover points
-	FVector internalEdge = (leftPoint - rightPoint);
-	float internalEdgeLength = internalEdge.Size();
-	internalEdge /= internalEdgeLength;
-
-	int numInternalPoints = (int)(internalEdgeLength / _coverPointMinDistanceOnEdge) + 1;
-	if (numInternalPoints <= 1) return;
+	FCoverPointSet& coverPoints = *job._coverPoints;
 
-	// optionally clamp to max. number of cover points for nav mesh edge
-	if (_maxNumPointsPerEdge > -1) numInternalPoints = FMath::Clamp<int>(numInternalPoints, 0, _maxNumPointsPerEdge);
-	float coverPointInterval = internalEdgeLength / (float)(numInternalPoints - 1);
+	// the index of a copied set is built here, off the game thread for async jobs. An index of an outdated type is replaced as well.
+	if (!coverPoints._index.IsValid() || coverPoints._index->GetType() != _indexType)
+	{
+		FBox bounds = job._bbox;
+		coverPoints._store.ForEachHandle([&](int32 handle) { bounds += coverPoints._store.GetLocation(handle); });
+		coverPoints.BuildIndex(_indexType, bounds, _coverPointMinDistanceOnEdge, _coverPointMinDistance);
+	}
 
-	FVector startLoc = rightPoint;
+	if (job._incremental)
+	{
+		// keep the cover points outside of the bbox, only the region itself is generated again
+		coverPoints._index->EnsureBounds(job._bbox, coverPoints._store);
+		RemoveCoverPointsInRegion(coverPoints, job._bbox);
+	}
 
-	// check if we should place a cover spot on right end point of nav edge
-	if (hasRightSidePoint || AreaAlreadyHasCoverPoint(startLoc))
+	// points of a copied set keep their cached visibility, unless the cache layout changed
+	if (!_buildVisibilityCache)
+	{
+		coverPoints._visibility.Reset();
+	}
+	else if (!coverPoints._visibility.Matches(_visibilityCellSize, _visibilityRange))
 	{
-		// move the starting position further along the internal edge and decrease the total number of internal points
-		startLoc += internalEdge * coverPointInterval;
-		numInternalPoints--;
+		coverPoints._visibility.Init(_visibilityCellSize, _visibilityRange);
 	}
-	// check if we should place a cover spot on left end point of nav edge
-	if (hasLeftSidePoint || AreaAlreadyHasCoverPoint(startLoc + internalEdge * coverPointInterval * (numInternalPoints - 1)))
+
+	if (!_buildExposureSectors)
 	{
-		numInternalPoints--;
+		coverPoints._exposure.Reset();
 	}
-	
-	// generate internal points
-	for (int idx = 0; idx < numInternalPoints; idx++)
+	else if (!coverPoints._exposure.Matches(_exposureRange))
 	{
-		FVector pointLocation = startLoc + idx * internalEdge * coverPointInterval;
-		if (!InsideGenerationVolume(pointLocation, bbox)) continue;
+		coverPoints._exposure.Init(_exposureRange);
+	}
+}
 
-		// an internal point can only be useful if one can lean over it (internal points are not at the sides of obstacles)
-		if (ProvidesCover(world, pointLocation, obstNormal) && CanLeanOver(world, pointLocation, obstNormal))
-		{
-			bool canStand = false; // if agent can lean over, standing isn't safe
-			FVector dirToCover = -obstNormal;
-			FVector leanDir = FVector::UpVector;
+void ACoverPointGenerator::EndCoverPointUpdate(FCoverGenerationJob& job) const
+{
+	if (IsJobSuperseded(job)) return;
 
-			StoreNewCoverPoint(pointLocation, dirToCover, leanDir, canStand);
-		}
-	}
+	FCoverPointSet& coverPoints = *job._coverPoints;
+	int numCoverPoints = coverPoints._store.Num();
+	UE_LOG(LogTemp, Log, TEXT("Num cover points: %d"), numCoverPoints);
+
+	// apply index optimization
+	coverPoints._index->Compact();
+	coverPoints._store.Shrink();
+
+	job._succeeded = true;
+}
+
+void ACoverPointGenerator::ResetCoverPointData()
+{
+	CancelGenerationJobs();
+	_coverPointSet.Reset();
 }
 
-void ACoverPointGenerator::GenerateSidePoints(UWorld* world, const FVector& leftVertex, const FVector& rightVertex, const FVector& edgeDir, const FVector& obstNormal, const FBox& bbox, FVector& outLeftSide, FVector& outRightSide)
+void ACoverPointGenerator::RemoveCoverPointsInRegion(FCoverPointSet& coverPoints, const FBox& bbox) const
 {
-	outLeftSide = leftVertex;
-	outRightSide = rightVertex;
+	TArray<int32> removedHandles;
+	coverPoints._index->QueryBox(bbox, coverPoints._store, removedHandles);
 
-	FVector rightToNormal = FVector::CrossProduct(FVector::UpVector, obstNormal);
-	auto storeSidePoint = [&](const FVector& location, const FVector& dirToCover, FVector leanDirection, FVector& outSidePoint)
+	for (int32 handle : removedHandles)
 	{
-		if (!AreaAlreadyHasCoverPoint(location))
-		{
-			bool canStand = CanStand(world, location, -dirToCover);
-			if (!canStand)
-			{
-				leanDirection.Z = CanLeanOver(world, location, obstNormal) ? 1.0f : 0.0f;
-			}
+		coverPoints._index->Remove(handle, coverPoints._store.GetLocation(handle));
+		coverPoints._store.Remove(handle);
+		coverPoints._visibility.Clear(handle);
+		coverPoints._exposure.Clear(handle);
+	}
+}
 
-			StoreNewCoverPoint(location, dirToCover, leanDirection, canStand);
-			outSidePoint = location;
-		}
-	};
-	
-	// check if there is a cover point at the left side and store it
-	FVector leftSideCoverPoint;
-	bool hasLeftSidePoint = GetSideCoverPoint(world, leftVertex, rightToNormal, obstNormal, edgeDir, leftSideCoverPoint);
-	if (hasLeftSidePoint && InsideGenerationVolume(leftSideCoverPoint, bbox))
-		storeSidePoint(leftSideCoverPoint, -obstNormal, rightToNormal, outLeftSide);
-
-	// check if there is a cover point at the right side and store it
-	FVector rightSideCoverPoint;
-	bool hasRightSidePoint = GetSideCoverPoint(world, rightVertex, -rightToNormal, obstNormal, -edgeDir, rightSideCoverPoint);
-	if (hasRightSidePoint && InsideGenerationVolume(rightSideCoverPoint, bbox))
-		storeSidePoint(rightSideCoverPoint, -obstNormal, -rightToNormal, outRightSide);
-}
-
-// The navigation mesh is not perfect. Therefore, we cannot assume that nav-mesh edges perfectly represent obstacle information. This method performs a sweep test 
-//  along the obstacle to find the side of an obstacle.
-bool ACoverPointGenerator::GetSideCoverPoint(UWorld* world, const FVector& navVert, const FVector& leanDirection, const FVector& obstNormal, const FVector& edgeDir, FVector& outSideCoverPoint) const
-{
-	const float vertOffset = _minCrouchCoverHeight;
-
-	// decide whether we should search along the left or right to find a cover spot
-	FVector startPoint = navVert;
-	startPoint.Z += vertOffset;
-	FVector projectEnd = startPoint + -obstNormal * _obstacleCheckDistance;
-	
-	FHitResult projectHit;
-	PerformLineTrace(world, startPoint, projectEnd, projectHit);
-
-	// Lambda that performs the sweep test to find the edge of an obstacle (and thus side cover point).
-	// If sweeping in lean direction: currently not in front of obstacle, stop with the first line trace that intersects the obstacle.
-	// If sweeping in opposite lean direction: currently in front of obstacle, stop wtih the first line trace that does not intersect the obstacle, store last intersection.
-	bool foundEndPoint = false;
-	auto findEdgePoint = [&](bool sweepInLeanDir) -> FVector
-	{
-		FVector _sidePoint;
-		FHitResult sideHitCheck;
-
-		FVector edgeDirection = sweepInLeanDir ? edgeDir : -edgeDir;
-		float lastDistance = projectHit.Distance;
-
-		for (int i = 0; i < _numObstacleSideChecks; i++)
-		{
-			FVector start = startPoint + (i + 1) * edgeDirection * _obstacleSideCheckInterval;
-			FVector stop = start + -obstNormal * _obstacleCheckDistance;
 
-			PerformLineTrace(world, start, stop, sideHitCheck);
-			bool foundEdge = sweepInLeanDir != sideHitCheck.bBlockingHit;
-			if (foundEdge)
-			{
-				// edge found: offset the resulting point from the obstacle such that there is a clearance of _coverPointOffset
-				float distToObstacle = sweepInLeanDir ? lastDistance : sideHitCheck.Distance;
-				float offsetFromObstacle = distToObstacle - _coverPointOffset;
-				float leanOffset = sweepInLeanDir ? _coverPointOffset + _obstacleSideCheckInterval : _coverPointOffset;
-
-				_sidePoint = start - leanDirection * leanOffset + -obstNormal * offsetFromObstacle;
-				foundEndPoint = true;
-				break;
-			}
+/*
+---------- Publishing ------------
+*/
 
-			lastDistance = sideHitCheck.Distance;
-		}
+// Can be called from any thread. The result is published by the game thread, unless a newer request came in.
+void ACoverPointGenerator::CompleteGenerationJob(const FCoverGenerationJobPtr& job)
+{
+	FScopeLock lock(&_finishedJobLock);
+	if (IsJobSuperseded(*job)) return;
 
-		return _sidePoint;
-	};
+	_finishedJob = job;
+}
+
+void ACoverPointGenerator::PublishFinishedJob()
+{
+	FCoverGenerationJobPtr job;
+	{
+		FScopeLock lock(&_finishedJobLock);
+		job = MoveTemp(_finishedJob);
+	}
 
-	// Find side cover point: sweep direction depends on whether we're already in front of the obstacle or not.
-	bool sweepInEdgeDirection = projectHit.bBlockingHit;
-	FVector sidePoint = findEdgePoint(sweepInEdgeDirection);
+	if (!job.IsValid() || IsJobSuperseded(*job)) return;
 
-	// make sure resulting side cover point is valid (may not be true due to nav-mesh imperfections)
-	if (foundEndPoint)
+	// swap in the new set, queries that still hold the previous set keep it alive until they are done
+	if (job->_succeeded)
 	{
-		FVector visionFromSideCheckStart = sidePoint + leanDirection * (_sideLeanOffset + _coverPointOffset);
-		FVector visionFromSideCheckStop = visionFromSideCheckStart + -obstNormal * _obstacleCheckDistance;
+		_coverPointSet = job->_coverPoints;
+		_needsRedrawing = true;
+	}
+	_generationInProgress = false;
+}
 
-		FHitResult visionFromSideCheck;
-		PerformLineTrace(world, visionFromSideCheckStart, visionFromSideCheckStop, visionFromSideCheck);
+void ACoverPointGenerator::CancelGenerationJobs()
+{
+	_generationSerial.Increment();
+	_timeSlicedJob.Reset();
+	_generationInProgress = false;
 
-		if (!visionFromSideCheck.bBlockingHit)
-		{
-			// vision not blocked from side: valid side cover point
-			sidePoint.Z -= vertOffset;
-			outSideCoverPoint = sidePoint;
+	FScopeLock lock(&_finishedJobLock);
+	_finishedJob.Reset();
+}
 
-			return true;
-		}
+bool ACoverPointGenerator::IsJobSuperseded(const FCoverGenerationJob& job) const
+{
+	return job._serial != _generationSerial.GetValue();
+}
+
+
+/*
+---------- Time-sliced generation ------------
+*/
+
+void ACoverPointGenerator::StartTimeSlicedGeneration(const FCoverGenerationJobPtr& job)
+{
+	// gathering and culling the edges needs no traces, it is done right away
+	TArray<FVector> edgeVertices;
+	TArray<uint8> edgeProfiles;
+	if (!GatherProfileNavMeshEdges(job->_bbox, edgeVertices, edgeProfiles))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No NavSystem found!"));
+		CompleteGenerationJob(job);
+		return;
 	}
 
-	return false;
+	BuildNavEdgeTable(*job, edgeVertices, edgeProfiles);
+	BeginCoverPointUpdate(*job);
+
+	_timeSlicedJob = job;
+}
+
+void ACoverPointGenerator::AdvanceTimeSlicedGeneration()
+{
+	UWorld* world = GetWorld();
+	FCoverGenerationJob& job = *_timeSlicedJob;
+	const double budget = FMath::Max(_timeSliceBudgetMs, 0.1f) / 1000.0;
+	const int32 edgesPerStep = FMath::Max(_timeSliceEdgesPerStep, 1);
+	const int32 verticesPerStep = edgesPerStep * 2;
+	const double startTime = FPlatformTime::Seconds();
+
+	// at least one step is done every tick, so the job always finishes
+	do
+	{
+		if (job._nextVertex < job._navVertices.Num())
+		{
+			int32 numVertices = FMath::Min(verticesPerStep, job._navVertices.Num() - job._nextVertex);
+			ProjectNavVertices(world, job, job._nextVertex, numVertices);
+			job._nextVertex += numVertices;
+		}
+		else if (job._nextEdge < job._navEdges.Num())
+		{
+			int32 numEdges = FMath::Min(edgesPerStep, job._navEdges.Num() - job._nextEdge);
+			GenerateCoverPoints(world, job, job._nextEdge, numEdges);
+			job._nextEdge += numEdges;
+		}
+		else if (job._nextNewHandle < job._newHandles.Num())
+		{
+			int32 numHandles = FMath::Min(edgesPerStep, job._newHandles.Num() - job._nextNewHandle);
+			BuildVisibilityCache(world, job, job._nextNewHandle, numHandles);
+			job._nextNewHandle += numHandles;
+		}
+		else
+		{
+			EndCoverPointUpdate(job);
+			CompleteGenerationJob(_timeSlicedJob);
+			_timeSlicedJob.Reset();
+			PublishFinishedJob();
+			return;
+		}
+	} while (FPlatformTime::Seconds() - startTime < budget);
 }
 
 
 /*
----------- Tests ------------
+---------- Baking ------------
 */
 
-bool ACoverPointGenerator::ProvidesCover(UWorld* world, const FVector& coverLocation, const FVector& coverFaceNormal) const
+void ACoverPointGenerator::BakeCoverData()
 {
-	FVector checkStart = coverLocation;
-	checkStart.Z += _minCrouchCoverHeight;
-	FVector checkStop = checkStart + -coverFaceNormal * _obstacleCheckDistance;
-	
-	FHitResult outHit;
-	PerformLineTrace(world, checkStart, checkStop, outHit);
+	if (!GetWorld() || _generationInProgress) return;
+
+	FBox bounds = ALevelBounds::CalculateLevelBounds(GetLevel());
+	if (!bounds.IsValid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Level has no bounds, nothing to bake"));
+		return;
+	}
 
-	return outHit.bBlockingHit;
+	// generate synchronously, the bake is written right after
+	FCoverGenerationJobPtr job = CreateGenerationJob(bounds, false);
+	job->_coverPoints = MakeShared<FCoverPointSet, ESPMode::ThreadSafe>();
+	_Initialize(*job);
+	CompleteGenerationJob(job);
+	PublishFinishedJob();
+	if (!job->_succeeded) return;
+
+	FCoverPointSet& coverPoints = *job->_coverPoints;
+
+	FCoverBakeHeader header;
+	header._navMeshHash = ComputeNavMeshHash(bounds);
+	header._parameterHash = ComputeParameterHash();
+	header._bounds = bounds;
+	header._indexType = _indexType;
+
+	FString path = GetBakeFilePath();
+	if (CoverBakeData::Save(path, header, coverPoints))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Baked %d cover points to %s"), coverPoints._store.Num(), *path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write baked cover data to %s"), *path);
+	}
+
+	DrawDebugData();
 }
 
-bool ACoverPointGenerator::CanStand(UWorld* world, FVector coverLocation, FVector coverFaceNormal) const
+bool ACoverPointGenerator::LoadBakedCoverData()
 {
-	FVector checkStart = coverLocation;
-	checkStart.Z += _minStandCoverHeight;
-	FVector checkStop = checkStart + -coverFaceNormal * _obstacleCheckDistance;
+	FDateTime timeBefore = FDateTime::Now();
+
+	// the whole file is read at once, the points are deserialized straight from that buffer
+	FString path = GetBakeFilePath();
+	TArray<uint8> fileData;
+	if (!FFileHelper::LoadFileToArray(fileData, *path, FILEREAD_Silent))
+	{
+		UE_LOG(LogTemp, Log, TEXT("No baked cover data found at %s"), *path);
+		return false;
+	}
+
+	FCoverBakeHeader header;
+	if (!CoverBakeData::LoadHeader(fileData, header))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Baked cover data %s is invalid or has an old version, bake it again"), *path);
+		return false;
+	}
+
+	if (header._parameterHash != ComputeParameterHash() || header._navMeshHash != ComputeNavMeshHash(header._bounds))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Baked cover data %s does not match the navmesh or generation parameters, regenerating"), *path);
+		UpdateCoverpointData(header._bounds);
+		return false;
+	}
+
+	FCoverPointSetPtr coverPoints = MakeShared<FCoverPointSet, ESPMode::ThreadSafe>();
+	if (!CoverBakeData::LoadPoints(fileData, *coverPoints))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not read the cover points of %s"), *path);
+		return false;
+	}
 
-	FHitResult outHit;
-	PerformLineTrace(world, checkStart, checkStop, outHit);
+	// the index is not part of the bake, rebuilding it from the points needs no line traces
+	coverPoints->BuildIndex(_indexType, header._bounds, _coverPointMinDistanceOnEdge, _coverPointMinDistance);
+	coverPoints->_index->Compact();
 
-	return outHit.bBlockingHit;
+	// the bake replaces whatever was requested before
+	CancelGenerationJobs();
+	_coverPointSet = coverPoints;
+	_needsRedrawing = true;
+
+	float timeTaken = (FDateTime::Now() - timeBefore).GetTotalSeconds();
+	UE_LOG(LogTemp, Log, TEXT("Loaded %d baked cover points in %f"), coverPoints->_store.Num(), timeTaken);
+
+	return true;
 }
 
-bool ACoverPointGenerator::CanLeanOver(UWorld* world, const FVector& coverLocation, const FVector& coverFaceNormal) const
+FString ACoverPointGenerator::GetBakeFilePath() const
 {
-	FVector checkStart = coverLocation;
-	checkStart.Z += _maxAttackOverEdgeHeight;
-	FVector checkStop = checkStart + -coverFaceNormal * _obstacleCheckDistance;
+	return CoverBakeData::GetBakeFilePath(UWorld::RemovePIEPrefix(GetOutermost()->GetName()));
+}
 
-	FHitResult outHit;
-	PerformLineTrace(world, checkStart, checkStop, outHit);
+uint32 ACoverPointGenerator::ComputeNavMeshHash(const FBox& bbox) const
+{
+	// the cover points only depend on the boundary edges of the navmeshes
+	TArray<FVector> edgeVertices;
+	TArray<uint8> edgeProfiles;
+	if (!GatherProfileNavMeshEdges(bbox, edgeVertices, edgeProfiles)) return 0;
 
-	return !outHit.bBlockingHit;
+	uint32 hash = FCrc::MemCrc32(edgeVertices.GetData(), edgeVertices.Num() * sizeof(FVector));
+	return FCrc::MemCrc32(edgeProfiles.GetData(), edgeProfiles.Num(), hash);
 }
 
-bool ACoverPointGenerator::CanLeanOver(const UCoverPoint* cp) const
+uint32 ACoverPointGenerator::ComputeParameterHash() const
 {
-	const float epsilon = 0.0001;
-	return (cp->_leanDirection.Z > epsilon);
+	// every parameter that changes the generated cover points
+	uint32 hash = GetTypeHash(_coverPointMinDistanceOnEdge);
+	hash = HashCombine(hash, GetTypeHash(_coverPointMinDistance));
+	hash = HashCombine(hash, GetTypeHash(_maxNumPointsPerEdge));
+	hash = HashCombine(hash, GetTypeHash(_coverPointOffset));
+	hash = HashCombine(hash, GetTypeHash(_minCrouchCoverHeight));
+	hash = HashCombine(hash, GetTypeHash(_minStandCoverHeight));
+	hash = HashCombine(hash, GetTypeHash(_maxAttackOverEdgeHeight));
+	hash = HashCombine(hash, GetTypeHash(_standAttackHeight));
+	hash = HashCombine(hash, GetTypeHash(_crouchAttackHeight));
+	hash = HashCombine(hash, GetTypeHash(_sideLeanOffset));
+	hash = HashCombine(hash, GetTypeHash(_obstacleCheckDistance));
+	hash = HashCombine(hash, GetTypeHash(_obstacleSideCheckInterval));
+	hash = HashCombine(hash, GetTypeHash(_numObstacleSideChecks));
+	hash = HashCombine(hash, GetTypeHash((uint8)_sideSearchMode));
+	hash = HashCombine(hash, GetTypeHash(_sideSearchMaxDistance));
+	hash = HashCombine(hash, GetTypeHash(_sideSearchTolerance));
+	hash = HashCombine(hash, GetTypeHash((uint8)_mergeWallSegments));
+	hash = HashCombine(hash, GetTypeHash(_wallSegmentMaxDeviation));
+	hash = HashCombine(hash, GetTypeHash((uint8)_complexCanLeanOverObstacleTest));
+	hash = HashCombine(hash, GetTypeHash((uint8)_buildVisibilityCache));
+	hash = HashCombine(hash, GetTypeHash(_visibilityCellSize));
+	hash = HashCombine(hash, GetTypeHash(_visibilityRange));
+	hash = HashCombine(hash, GetTypeHash((uint8)_buildExposureSectors));
+	hash = HashCombine(hash, GetTypeHash(_exposureRange));
+	for (const FCoverAgentProfile& profile : _agentProfiles)
+	{
+		hash = HashCombine(hash, GetTypeHash(profile._agentRadius));
+		hash = HashCombine(hash, GetTypeHash(profile._agentHeight));
+		hash = HashCombine(hash, GetTypeHash(profile._minCrouchCoverHeight));
+		hash = HashCombine(hash, GetTypeHash(profile._minStandCoverHeight));
+		hash = HashCombine(hash, GetTypeHash(profile._maxAttackOverEdgeHeight));
+	}
+
+	return hash;
 }
 
-bool ACoverPointGenerator::CanLeanSide(const UCoverPoint* cp) const
+
+/*
+---------- Navmesh updates ------------
+*/
+
+void ACoverPointGenerator::OnNavigationDirty(const FBox& dirtyBounds)
 {
-	const float epsilon = 0.0001f;
-	FVector2D leanDir2D = FVector2D(cp->_leanDirection);
-	return (leanDir2D.SizeSquared() > epsilon);
+	// nothing to keep up to date if no cover point data was generated yet
+	if (!_coverPointSet.IsValid()) return;
+
+	if (_dirtyNavBounds.Num() == 0)
+	{
+		_dirtyNavBoundsAge = 0.0f;
+	}
+
+	_dirtyNavBounds.Emplace(dirtyBounds);
 }
 
-bool ACoverPointGenerator::AreaAlreadyHasCoverPoint(const FVector& position) const
+void ACoverPointGenerator::FlushDirtyNavMeshTiles()
 {
-	FBox bbox(position, position);
+	TArray<TPair<const ARecastNavMesh*, uint8>> navMeshes;
+	GetProfileNavMeshes(navMeshes);
 
-	// example code how to query octree
-	for (TCoverPointOctree::TConstElementBoxIterator<> it(*_coverPoints, bbox); it.HasPendingElements(); it.Advance())
+	// the rebuilt tiles cover more than the dirty areas themselves
+	TArray<FBox> tilesBounds;
+	for (const TPair<const ARecastNavMesh*, uint8>& navMesh : navMeshes)
 	{
-		if ((it.GetCurrentElement()._coverPoint->_location - position).Size() < _coverPointMinDistance)
+		TArray<int32> tileIndices;
+		navMesh.Key->GetNavMeshTilesIn(_dirtyNavBounds, tileIndices);
+		for (int32 tileIdx : tileIndices) tilesBounds.Emplace(navMesh.Key->GetNavMeshTileBounds(tileIdx));
+	}
+	_dirtyNavBounds.Empty();
+
+	// nav points are projected to the ground, so also include the space below the tile they can be projected to, like the edge culling does
+	const FVector tileMargin(0.0f, 0.0f, MaxNavProjectionHeight);
+
+	for (FBox tileBounds : tilesBounds)
+	{
+		if (!tileBounds.IsValid) continue;
+
+		tileBounds = tileBounds.ExpandBy(tileMargin);
+
+		// merge with pending regions it touches, so neighbouring tiles are regenerated in one go
+		for (int32 regionIdx = _pendingRegions.Num() - 1; regionIdx >= 0; regionIdx--)
 		{
-			return true;
+			if (_pendingRegions[regionIdx].Intersect(tileBounds))
+			{
+				tileBounds += _pendingRegions[regionIdx];
+				_pendingRegions.RemoveAtSwap(regionIdx);
+			}
 		}
-	}
 
-	return false;
+		_pendingRegions.Emplace(tileBounds);
+	}
 }
 
-bool ACoverPointGenerator::GetObstacleFaceNormal(UWorld* world, const FVector& edgeStart, const FVector& edgeDir, float edgeLength, FHitResult& outHit) const
+void ACoverPointGenerator::ProcessPendingRegions()
 {
-	// get normal of obstacle face this edge is parallel to
-	FVector rightVec = FVector::CrossProduct(FVector::UpVector, edgeDir);
-	FVector checkStart = edgeStart + edgeDir * edgeLength * 0.5f;
-	checkStart.Z += 20.0f;
-	FVector checkStop = checkStart + rightVec * _obstacleCheckDistance;
+	// regions are regenerated one after another, so async generation never runs twice at the same time
+	if (_pendingRegions.Num() == 0 || _generationInProgress) return;
 
-	PerformLineTrace(world, checkStart, checkStop, outHit);
-
-	return outHit.bBlockingHit;
+	FBox region = _pendingRegions.Pop(false);
+	UpdateCoverpointDataInRegion(region);
 }
 
 
 /*
----------- Helper methods ------------
+---------- Generation ------------
 */
 
-void ACoverPointGenerator::ProjectNavPointsToGround(UWorld* world, FVector& p1, FVector& p2) const
+void ACoverPointGenerator::ProjectNavVertices(UWorld* world, FCoverGenerationJob& job, int32 firstVertex, int32 numVertices) const
+{
+	FCoverWorldRaycaster raycaster(world, _parallelGeneration);
+	FCoverGenerationCore core(GetGenerationParams(), raycaster);
+	core.ProjectVertices(job._navVertices, firstVertex, numVertices, [&]() { return IsJobSuperseded(job); });
+}
+
+void ACoverPointGenerator::GenerateCoverPoints(UWorld* world, FCoverGenerationJob& job, int32 firstEdge, int32 numEdges) const
+{
+	FCoverWorldRaycaster raycaster(world, _parallelGeneration);
+	FCoverGenerationCore core(GetGenerationParams(), raycaster);
+	core.GenerateCoverPoints(job._navVertices, job._navEdges, firstEdge, numEdges, job._bbox, *job._coverPoints, job._newHandles,
+		[&]() { return IsJobSuperseded(job); });
+}
+
+void ACoverPointGenerator::BuildVisibilityCache(UWorld* world, FCoverGenerationJob& job, int32 firstNewHandle, int32 numNewHandles) const
 {
-	const float maxProjectionHeight = 500.0f;
-	FHitResult projectHit;
-	
-	// first vertex
-	FVector projectEnd = p1 + FVector::DownVector * maxProjectionHeight;
-	PerformLineTrace(world, p1, projectEnd, projectHit);
-	if (projectHit.bBlockingHit) p1 = projectHit.Location;
-	
-	// second vertex
-	projectEnd = p2 + FVector::DownVector * maxProjectionHeight;
-	PerformLineTrace(world, p2, projectEnd, projectHit);
-	if (projectHit.bBlockingHit) p2 = projectHit.Location;
+	FCoverWorldRaycaster raycaster(world, _parallelGeneration);
+	FCoverGenerationCore core(GetGenerationParams(), raycaster);
+	core.BuildVisibilityCache(*job._coverPoints, job._newHandles, firstNewHandle, numNewHandles, [&]() { return IsJobSuperseded(job); });
+	core.BuildExposureSectors(*job._coverPoints, job._newHandles, firstNewHandle, numNewHandles, [&]() { return IsJobSuperseded(job); });
+}
+
+FCoverGenerationParams ACoverPointGenerator::GetGenerationParams() const
+{
+	FCoverGenerationParams params;
+	params._coverPointMinDistanceOnEdge = _coverPointMinDistanceOnEdge;
+	params._coverPointMinDistance = _coverPointMinDistance;
+	params._maxNumPointsPerEdge = _maxNumPointsPerEdge;
+	params._coverPointOffset = _coverPointOffset;
+	params._profiles.SetNum(1);
+	params._profiles[0]._minCrouchCoverHeight = _minCrouchCoverHeight;
+	params._profiles[0]._minStandCoverHeight = _minStandCoverHeight;
+	params._profiles[0]._maxAttackOverEdgeHeight = _maxAttackOverEdgeHeight;
+	if (_agentProfiles.Num() > 0)
+	{
+		params._profiles.SetNum(GetNumAgentProfiles());
+		for (int32 profileIdx = 0; profileIdx < params._profiles.Num(); profileIdx++)
+		{
+			params._profiles[profileIdx]._minCrouchCoverHeight = _agentProfiles[profileIdx]._minCrouchCoverHeight;
+			params._profiles[profileIdx]._minStandCoverHeight = _agentProfiles[profileIdx]._minStandCoverHeight;
+			params._profiles[profileIdx]._maxAttackOverEdgeHeight = _agentProfiles[profileIdx]._maxAttackOverEdgeHeight;
+		}
+	}
+	params._standAttackHeight = _standAttackHeight;
+	params._crouchAttackHeight = _crouchAttackHeight;
+	params._sideLeanOffset = _sideLeanOffset;
+	params._obstacleCheckDistance = _obstacleCheckDistance;
+	params._obstacleSideCheckInterval = _obstacleSideCheckInterval;
+	params._numObstacleSideChecks = _numObstacleSideChecks;
+	params._sideSearchMode = _sideSearchMode;
+	params._sideSearchMaxDistance = _sideSearchMaxDistance;
+	params._sideSearchTolerance = _sideSearchTolerance;
+	params._complexCanLeanOverObstacleTest = _complexCanLeanOverObstacleTest;
+	params._maxProjectionHeight = MaxNavProjectionHeight;
+	return params;
 }
 
+/*
+---------- Helper methods ------------
+*/
+
 const void ACoverPointGenerator::DrawDebugData() const
 {
-	if (!_coverPoints.IsValid()) return;
+	if (!_coverPointSet.IsValid()) return;
+	const FCoverPointStore& store = _coverPointSet->_store;
 
 	UWorld* world = GetWorld();
 	if (!world)
@@ -545,53 +1036,79 @@ const void ACoverPointGenerator::DrawDebugData() const
 	const float debugSphereExtent = 30.0f;
 	const float debugLineLength = 80.0f;
 	const float debugLineVertOffset = 10.0f;
-	// loop through octree
-	for (TCoverPointOctree::TConstElementBoxIterator<> it(*_coverPoints, _coverPoints->GetRootBounds()); it.HasPendingElements(); it.Advance())
+	store.ForEachHandle([&](int32 handle)
 	{
-		FCoverPointOctreeElement el = it.GetCurrentElement();
-		UCoverPoint* cp = el._coverPoint;
-		
-		if (cp != nullptr)
+		const FCoverPointData cp = store.Get(handle);
+
+		if (_drawCoverPoints)
 		{
-			if (_drawCoverPoints)
-			{
-				DrawDebugSphere(world, cp->_location, debugSphereExtent, 7, FColor::Cyan, true);
-			}
+			DrawDebugSphere(world, cp._location, debugSphereExtent, 7, FColor::Cyan, true);
+		}
 
-			if (_drawCoverPointsNormal)
-			{
-				FVector startPoint = cp->_location + FVector::UpVector * debugLineVertOffset;
-				FVector stopPoint = startPoint + cp->_dirToCover * debugLineLength * -1.0f;
-				DrawDebugLine(world, startPoint, stopPoint, FColor::Magenta, true);
-			}
+		if (_drawCoverPointsNormal)
+		{
+			FVector startPoint = cp._location + FVector::UpVector * debugLineVertOffset;
+			FVector stopPoint = startPoint + cp._dirToCover * debugLineLength * -1.0f;
+			DrawDebugLine(world, startPoint, stopPoint, FColor::Magenta, true);
+		}
 
-			if (_drawCoverPointsLeanDirection)
-			{
-				FVector startPoint = cp->_location + FVector::UpVector * debugLineVertOffset;
-				FVector stopPoint = startPoint + cp->_leanDirection * debugLineLength;
-				DrawDebugLine(world, startPoint, stopPoint, FColor::Green, true);
-			}
+		if (_drawCoverPointsLeanDirection)
+		{
+			FVector startPoint = cp._location + FVector::UpVector * debugLineVertOffset;
+			FVector stopPoint = startPoint + cp._leanDirection * debugLineLength;
+			DrawDebugLine(world, startPoint, stopPoint, FColor::Green, true);
 		}
-	}
+	});
 
 	_needsRedrawing = false;
 }
 
-void ACoverPointGenerator::StoreNewCoverPoint(const FVector& location, const FVector& dirToCover, const FVector& leanDir, const bool& canStand)
+void ACoverPointGenerator::GetProfileNavMeshes(TArray<TPair<const ARecastNavMesh*, uint8>>& outNavMeshes) const
 {
-	UCoverPoint* cp = NewObject<UCoverPoint>();
-	cp->Init(location, dirToCover, leanDir, canStand);
+	outNavMeshes.Reset();
 
-	_coverPoints->AddElement(FCoverPointOctreeElement(cp, _coverPointMinDistanceOnEdge));
-	_coverPointBuffer.Emplace(cp);
+	UWorld* world = GetWorld();
+	UNavigationSystemV1* navSystem = world ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(world) : nullptr;
+	if (!navSystem) return;
+
+	// without profiles, the cover points are generated for the default agent
+	if (_agentProfiles.Num() == 0)
+	{
+		const ARecastNavMesh* navMeshData = Cast<ARecastNavMesh>(navSystem->GetDefaultNavDataInstance());
+		if (navMeshData) outNavMeshes.Emplace(navMeshData, 1);
+		return;
+	}
+
+	for (int32 profileIdx = 0; profileIdx < GetNumAgentProfiles(); profileIdx++)
+	{
+		const FCoverAgentProfile& profile = _agentProfiles[profileIdx];
+		const ARecastNavMesh* navMeshData = Cast<ARecastNavMesh>(navSystem->GetNavDataForProps(FNavAgentProperties(profile._agentRadius, profile._agentHeight)));
+		if (!navMeshData)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("No nav mesh found for cover agent profile %s"), *profile._name.ToString());
+			continue;
+		}
+
+		// profiles with the same nav mesh share its edges
+		TPair<const ARecastNavMesh*, uint8>* existing = outNavMeshes.FindByPredicate([&](const TPair<const ARecastNavMesh*, uint8>& navMesh) { return navMesh.Key == navMeshData; });
+		if (existing) existing->Value |= 1 << profileIdx;
+		else outNavMeshes.Emplace(navMeshData, 1 << profileIdx);
+	}
 }
 
-void ACoverPointGenerator::PerformLineTrace(UWorld* world, FVector& start, FVector& end, FHitResult& outHit) const
+int32 ACoverPointGenerator::GetNumAgentProfiles() const
 {
-	UKismetSystemLibrary::LineTraceSingle(world, start, end, ETraceTypeQuery::TraceTypeQuery1, false, TArray<AActor*>(), EDrawDebugTrace::None, outHit, true);
+	return FMath::Clamp(_agentProfiles.Num(), 1, MaxCoverAgentProfiles);
 }
 
-bool ACoverPointGenerator::InsideGenerationVolume(const FVector& point, const FBox& box) const
+int32 ACoverPointGenerator::GetAgentProfileIndex(FName profileName) const
 {
-	return FMath::PointBoxIntersection(point, box);
+	if (profileName.IsNone()) return 0;
+
+	for (int32 profileIdx = 0; profileIdx < GetNumAgentProfiles() && profileIdx < _agentProfiles.Num(); profileIdx++)
+	{
+		if (_agentProfiles[profileIdx]._name == profileName) return profileIdx;
+	}
+
+	return INDEX_NONE;
 }
@@ -5,7 +5,15 @@
 #include "CoverDataStructures.h"
 
 #include "GameFramework/Actor.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "CoverSpotGeneratorAsync.h"
+#include "CoverWorldRaycaster.h"
+#include "CoverPointStore.h"
+#include "CoverPointIndex.h"
+#include "CoverBakeData.h"
+#include "CoverGenerationJob.h"
+#include "CoverGenerationCore.h"
 #include "NavMesh/RecastNavMesh.h"
 #include "CoverPointGenerator.generated.h"
 
@@ -59,14 +67,77 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Side points")
 	int _numObstacleSideChecks = 10;
 
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Side points")
+	ECoverSideSearchMode _sideSearchMode = ECoverSideSearchMode::Linear;
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Side points")
+	float _sideSearchMaxDistance = 400.0f; // adaptive search: sides further away from a nav mesh vertex are not found
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Side points")
+	float _sideSearchTolerance = 2.0f; // adaptive search: the side is located to within this distance
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Wall segments")
+	bool _mergeWallSegments = true; // generate once per straight wall instead of once per nav mesh edge along it
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Wall segments")
+	float _wallSegmentMaxDeviation = 5.0f; // maximum distance of a merged nav mesh vertex to its wall segment
+
 	UPROPERTY(EditAnywhere, Category = "Parameters|Generation")
 	bool _asyncGeneration = true;
-	
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation")
+	bool _parallelGeneration = false; // spread the line traces of every generation stage over worker threads
+
+	// Generate on the game thread, spread over multiple frames. Takes precedence over async generation. The points are published at
+	// once after the last slice, queries keep seeing the previous cover points until then.
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Time slicing")
+	bool _timeSlicedGeneration = false;
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Time slicing")
+	float _timeSliceBudgetMs = 2.0f; // generation time per frame in milliseconds
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Time slicing")
+	int _timeSliceEdgesPerStep = 16; // nav edges whose traces are batched together, smaller steps follow the budget more closely
+
 	UPROPERTY(EditAnywhere, Category = "Parameters|Generation")
 	bool _complexCanLeanOverObstacleTest = false;
 
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation")
+	ECoverPointIndexType _indexType = ECoverPointIndexType::Octree; // spatial index used for cover point queries, a change is applied on the next generation
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Dynamic")
+	bool _regenerateOnNavMeshUpdate = false; // regenerate the cover points of navmesh tiles that are rebuilt at runtime
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Dynamic")
+	float _navMeshUpdateBatchTime = 0.5f; // time in seconds during which dirty navmesh areas are collected before regenerating
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Visibility")
+	bool _buildVisibilityCache = false; // cache which region cells see each cover point, so EQS tests can skip most of their traces
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Visibility")
+	float _visibilityCellSize = 1000.0f; // horizontal size of the region cells
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Visibility")
+	float _visibilityRange = 3000.0f; // cells further away from a cover point are not cached
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Exposure")
+	bool _buildExposureSectors = false; // measure how far each cover point is blocked in every direction, so EQS tests can answer with a lookup
+
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Exposure")
+	float _exposureRange = 2000.0f; // directions that are not blocked within this distance count as open
+
+	// Agents that get cover points, generated in one pass over the geometry. At most 8, the index of a profile is its bit in the points'
+	// profile mask. Without profiles, points are generated for the default nav mesh with the thresholds above.
+	UPROPERTY(EditAnywhere, Category = "Parameters|Generation|Profiles")
+	TArray<FCoverAgentProfile> _agentProfiles;
+
 #pragma endregion GENERATION_PROPERTIES
 
+#pragma region BAKE_PROPERTIES
+	UPROPERTY(EditAnywhere, Category = "Parameters|Bake")
+	bool _loadBakedCoverData = false; // load the level's baked cover data on begin play, a stale bake is regenerated instead
+#pragma endregion BAKE_PROPERTIES
+
 #pragma region DEBUG_PROPERTIES
 	UPROPERTY(EditAnywhere, Category = "Parameters|Debug")
 	bool _drawCoverPoints = false;
@@ -82,43 +153,74 @@ protected:
 
 	// Sets default values for this actor's properties
 	ACoverPointGenerator();
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type endPlayReason) override;
 	virtual void Tick(float dt) override;
 
 	// Management
-	void _Initialize(const FBox& bbox);
-	void _UpdateCoverPointData(const FBox& bbox);
+	void RequestGeneration(const FBox& bbox, bool incremental);
+	FCoverGenerationJobPtr CreateGenerationJob(const FBox& bbox, bool incremental);
+	void _Initialize(FCoverGenerationJob& job) const;
+	void GatherNavMeshEdges(const ARecastNavMesh* navMeshData, const FBox& bbox, TArray<FVector>& outEdgeVertices, TFunctionRef<bool()> isCancelled) const;
+	bool GatherProfileNavMeshEdges(const FBox& bbox, TArray<FVector>& outEdgeVertices, TArray<uint8>& outEdgeProfiles) const; // profiles of every edge, false if there is no nav mesh
+	bool GatherProfileNavMeshEdges(const FBox& bbox, TArray<FVector>& outEdgeVertices, TArray<uint8>& outEdgeProfiles, TFunctionRef<bool()> isCancelled) const; // polled per tile
+	void BuildNavEdgeTable(FCoverGenerationJob& job, const TArray<FVector>& edgeVertices, const TArray<uint8>& edgeProfiles) const;
+	void ProjectNavVertices(UWorld* world, FCoverGenerationJob& job, int32 firstVertex, int32 numVertices) const;
+	void _UpdateCoverPointData(FCoverGenerationJob& job) const;
+	void BeginCoverPointUpdate(FCoverGenerationJob& job) const;
+	void EndCoverPointUpdate(FCoverGenerationJob& job) const;
 	void ResetCoverPointData();
-
-	// Generation
-	void GenerateSidePoints(UWorld* world, const FVector& leftEndPoint, const FVector& rightEndPoint, const FVector& edgeDir, const FVector& obstNormal, const FBox& bbox, FVector& outLeftSide, FVector& outRightSide);
-	void GenerateInternalPoints(UWorld* world, const FVector& leftPoint, const FVector& rightPoint, const FVector& obstNormal, const FBox& bbox, bool hasLeftSidePoint, bool hasRightSidePoint);
-	bool GetSideCoverPoint(UWorld* world, const FVector& navVert, const FVector& leanDirection, const FVector& obstNormal, const FVector& edgeDir, FVector& outSideCoverPoint) const;
-	
-	// Tests
-	FORCEINLINE bool GetObstacleFaceNormal(UWorld* world, const FVector& edgeStart, const FVector& edgeDir, float edgeLength, FHitResult& outHit) const; // returns false if no obstacle was found
-	FORCEINLINE bool AreaAlreadyHasCoverPoint(const FVector& position) const;
-	FORCEINLINE bool CanStand(UWorld* world, FVector coverLocation, FVector coverFaceNormal) const;
-	FORCEINLINE bool ProvidesCover(UWorld* world, const FVector& coverLocation, const FVector& coverFaceNormal) const;
-	FORCEINLINE bool CanLeanOver(UWorld* world, const FVector& coverLocation, const FVector& coverFaceNormal) const;
-	FORCEINLINE bool CanLeanOver(const UCoverPoint*) const;
-	FORCEINLINE bool CanLeanSide(const UCoverPoint*) const;
+	void RemoveCoverPointsInRegion(FCoverPointSet& coverPoints, const FBox& bbox) const;
+
+	// Publishing (jobs build a new set of cover points, the published set is only replaced on the game thread)
+	void CompleteGenerationJob(const FCoverGenerationJobPtr& job);
+	void PublishFinishedJob();
+	void CancelGenerationJobs();
+	FORCEINLINE bool IsJobSuperseded(const FCoverGenerationJob& job) const;
+
+	// Time-sliced generation
+	void StartTimeSlicedGeneration(const FCoverGenerationJobPtr& job);
+	void AdvanceTimeSlicedGeneration();
+
+	// Baking
+	bool LoadBakedCoverData();
+	FString GetBakeFilePath() const;
+	uint32 ComputeNavMeshHash(const FBox& bbox) const;
+	uint32 ComputeParameterHash() const;
+
+	// Navmesh updates
+	void OnNavigationDirty(const FBox& dirtyBounds);
+	void FlushDirtyNavMeshTiles();
+	void ProcessPendingRegions();
+
+	// Generation (runs the world independent generation core on the job's data, tracing against the world)
+	void GenerateCoverPoints(UWorld* world, FCoverGenerationJob& job, int32 firstEdge, int32 numEdges) const;
+	void BuildVisibilityCache(UWorld* world, FCoverGenerationJob& job, int32 firstNewHandle, int32 numNewHandles) const; // and the exposure sectors
+	FCoverGenerationParams GetGenerationParams() const;
 
 	// Helper methods
-	void ProjectNavPointsToGround(UWorld* world, FVector& p1, FVector& p2) const;
-	void StoreNewCoverPoint(const FVector& location, const FVector& dirToCover, const FVector& leanDir, const bool& canStand);
 	const void DrawDebugData() const;
-	FORCEINLINE void PerformLineTrace(UWorld* world, FVector& start, FVector& end, FHitResult& outHit) const;
-	FORCEINLINE bool InsideGenerationVolume(const FVector& point, const FBox& box) const;
+	void GetProfileNavMeshes(TArray<TPair<const ARecastNavMesh*, uint8>>& outNavMeshes) const; // profiles sharing a nav mesh are combined
 
 	// Member variables
-	UPROPERTY()
-	TArray<UCoverPoint*> _coverPointBuffer; // workaround: store points in TArray so they are properly garbage collected
-	TUniquePtr<TCoverPointOctree> _coverPoints;
-	mutable bool _isInitialized;
+	FCoverPointSetPtr _coverPointSet; // published cover points, queries always see a complete set
 	mutable bool _needsRedrawing;
-
-	// nav mesh data
-	FRecastDebugGeometry _navGeo;
+	FThreadSafeBool _generationInProgress;
+
+	// generation jobs: every request gets a new serial, jobs with an older serial are cancelled
+	FThreadSafeCounter _generationSerial;
+	FThreadSafeCounter _numRunningJobs; // async jobs that still reference this generator
+	FCriticalSection _finishedJobLock;
+	FCoverGenerationJobPtr _finishedJob; // completed job waiting to be published on the game thread
+	FCoverGenerationJobPtr _timeSlicedJob;
+	FBox _runningJobBBox;
+	bool _runningJobIncremental;
+
+	// dirty navmesh areas that have not been processed yet
+	TArray<FBox> _dirtyNavBounds;
+	float _dirtyNavBoundsAge;
+	TArray<FBox> _pendingRegions;
+	FDelegateHandle _navigationDirtyHandle;
 
 public:
 	// INTERFACE
@@ -126,12 +228,56 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void UpdateCoverpointData(const FBox& bbox);
 
+	// only regenerates the cover points inside the bbox, cover points outside of it are kept
+	UFUNCTION(BlueprintCallable)
+	void UpdateCoverpointDataInRegion(const FBox& bbox);
+
 	UFUNCTION(BlueprintCallable)
 	void ClearCoverpointData();
 
+	// generates the cover points of the whole level and writes them to the level's bake file
+	UFUNCTION(CallInEditor, Category = "Parameters|Bake")
+	void BakeCoverData();
+
+	UFUNCTION(BlueprintCallable)
+	TArray<FCoverPointData> GetCoverPointsWithinExtent(const FVector& position, float extent) const;
+
+	// creates a blueprint object for the cover point with the given handle, returns null if the handle is not valid (anymore)
 	UFUNCTION(BlueprintCallable)
-	TArray<UCoverPoint*> GetCoverPointsWithinExtent(const FVector& position, float extent) const;
+	UCoverPoint* CreateCoverPointObject(int32 handle);
 
 	static ACoverPointGenerator* Get(UWorld* world);
-	int GetNumberOfIntersectionsFromCover(const UCoverPoint* cp, const FVector& targetLocation) const;
+	FORCEINLINE bool IsGenerationInProgress() const { return _generationInProgress; }
+	int32 GetNumAgentProfiles() const;
+	int32 GetAgentProfileIndex(FName profileName) const; // none is the first profile, INDEX_NONE if there is no profile with the name
+	bool GetCoverPoint(int32 handle, FCoverPointData& outPoint) const;
+
+	// Batched queries: find the cover points inside any of the shapes in a single pass over the index and write their handles to the
+	// buffer, without duplicates. The handles refer to the returned set, which is null if no cover points were generated yet.
+	FCoverPointSetPtr GetCoverPointsInBoxes(TArrayView<const FBox> boxes, FCoverPointQueryBuffer& buffer) const;
+	FCoverPointSetPtr GetCoverPointsInSpheres(TArrayView<const FSphere> spheres, FCoverPointQueryBuffer& buffer) const;
+	FORCEINLINE FCoverPointSetPtr GetCoverPoints() const { return _coverPointSet; } // keep the returned pointer for as long as the points are used
+	// obstacles are not counted beyond this, unless the caller asks for less
+	static const int32 MaxCountedIntersections = 16;
+
+	// Returns how many obstacles are in between the cover point and a given target location, at most maxCount + 1 (once it is exceeded).
+	// With useVisibilityCache, a target in a cell the cached visibility marks as Visible counts as 0 without tracing. The cache samples the
+	// cells coarsely, so this is an approximation of the traced count.
+	int GetNumberOfIntersectionsFromCover(const FCoverPointData& cp, const FVector& targetLocation, int32 maxCount = MaxCountedIntersections,
+		bool useVisibilityCache = false) const;
+
+	// Batched form of GetNumberOfIntersectionsFromCover: adds the traces of the cover point to a batch that is executed as multi traces.
+	// Returns the first trace, or INDEX_NONE if useVisibilityCache is set and the cached visibility already tells there is nothing in between.
+	int32 AddIntersectionTraces(const FCoverPointData& cp, const FVector& targetLocation, FCoverRaycastBatch& traces, bool useVisibilityCache = false) const;
+	int GetNumberOfIntersections(const FCoverPointData& cp, const FCoverRaycastBatch& traces, int32 firstTrace) const;
+
+	// Cached visibility of the cover point from the region cell that contains the location, based on the static geometry at generation time.
+	// Unknown if the cache was not built, the location is out of range or the point is not part of the published set anymore.
+	ECoverVisibility GetCachedVisibility(const FCoverPointData& cp, const FVector& location) const;
+
+	// Looks the location up in the exposure sectors of the cover point, see FCoverExposureCache::Get. Unknown under the same conditions
+	// as GetCachedVisibility.
+	ECoverVisibility GetCachedExposure(const FCoverPointData& cp, const FVector& location, ECoverExposureHeight height) const;
+	// exposure sectors measured closest to the given height above the cover point
+	ECoverExposureHeight GetExposureHeight(float height) const;
 };
\ No newline at end of file
@@ -0,0 +1,260 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverPointIndex.h"
+
+TUniquePtr<FCoverPointIndex> FCoverPointIndex::Create(ECoverPointIndexType type, const FBox& bounds, float elementExtent, float cellSize)
+{
+	switch (type)
+	{
+	case ECoverPointIndexType::UniformGrid:
+		return MakeUnique<FCoverPointGridIndex>(cellSize);
+	default:
+		return MakeUnique<FCoverPointOctreeIndex>(bounds, elementExtent);
+	}
+}
+
+/*
+---------- Octree ------------
+*/
+
+FCoverPointOctreeIndex::FCoverPointOctreeIndex(const FBox& bounds, float elementExtent) : _elementExtent(elementExtent)
+{
+	_octree = MakeUnique<TCoverPointOctree>(bounds.GetCenter(), bounds.GetExtent().GetMax());
+}
+
+void FCoverPointOctreeIndex::Add(int32 handle, const FVector& location)
+{
+	if (_elementIds.Num() <= handle)
+	{
+		_elementIds.SetNum(handle + 1);
+	}
+	_octree->AddElement(FCoverPointOctreeElement(handle, location, _elementExtent, &_elementIds));
+}
+
+void FCoverPointOctreeIndex::Remove(int32 handle, const FVector& location)
+{
+	// element ids are updated by the octree while removing, so always read the id right before removal
+	_octree->RemoveElement(_elementIds[handle]);
+}
+
+void FCoverPointOctreeIndex::Empty()
+{
+	_octree->Destroy();
+	_elementIds.Empty();
+}
+
+void FCoverPointOctreeIndex::QueryBox(const FBox& bbox, const FCoverPointStore& store, TArray<int32>& outHandles) const
+{
+	// elements are inflated by the element extent, so only return the points that are really inside the bbox
+	for (TCoverPointOctree::TConstElementBoxIterator<> it(*_octree, bbox); it.HasPendingElements(); it.Advance())
+	{
+		int32 handle = it.GetCurrentElement()._handle;
+		if (FMath::PointBoxIntersection(store.GetLocation(handle), bbox))
+		{
+			outHandles.Add(handle);
+		}
+	}
+}
+
+void FCoverPointOctreeIndex::QueryBoxes(TArrayView<const FBox> boxes, const FCoverPointStore& store, FCoverPointQueryBuffer& buffer) const
+{
+	buffer.Begin(store.GetMaxHandle());
+
+	TArray<FBoxCenterAndExtent, TInlineAllocator<16>> queryBounds;
+	for (const FBox& box : boxes)
+	{
+		queryBounds.Emplace(box);
+	}
+
+	// a single traversal: a child node is only visited if its loose bounds touch at least one of the boxes
+	for (TCoverPointOctree::TConstIterator<> nodeIt(*_octree); nodeIt.HasPendingNodes(); nodeIt.Advance())
+	{
+		const TCoverPointOctree::FNode& node = nodeIt.GetCurrentNode();
+		const FOctreeNodeContext& context = nodeIt.GetCurrentContext();
+
+		for (TCoverPointOctree::ElementConstIt elementIt(node.GetElementIt()); elementIt; ++elementIt)
+		{
+			int32 handle = elementIt->_handle;
+			FVector location = store.GetLocation(handle);
+			for (const FBox& box : boxes)
+			{
+				if (FMath::PointBoxIntersection(location, box))
+				{
+					buffer.TryAdd(handle);
+					break;
+				}
+			}
+		}
+
+		FOREACH_OCTREE_CHILD_NODE(childRef)
+		{
+			if (!node.HasChild(childRef)) continue;
+
+			const FBoxCenterAndExtent& childBounds = context.GetChildContext(childRef).Bounds;
+			for (const FBoxCenterAndExtent& bounds : queryBounds)
+			{
+				if (Intersect(childBounds, bounds))
+				{
+					nodeIt.PushChild(childRef);
+					break;
+				}
+			}
+		}
+	}
+
+	buffer.End();
+}
+
+bool FCoverPointOctreeIndex::HasPointWithin(const FVector& position, float radius, const FCoverPointStore& store, uint8 profiles) const
+{
+	// every point closer than the element extent has an element box that contains the position itself
+	FBox bbox = radius <= _elementExtent ? FBox(position, position) : FBox(position - FVector(radius), position + FVector(radius));
+
+	for (TCoverPointOctree::TConstElementBoxIterator<> it(*_octree, bbox); it.HasPendingElements(); it.Advance())
+	{
+		const int32 handle = it.GetCurrentElement()._handle;
+		if ((store.GetProfiles(handle) & profiles) != 0 && (store.GetLocation(handle) - position).Size() < radius)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FCoverPointOctreeIndex::EnsureBounds(const FBox& bbox, const FCoverPointStore& store)
+{
+	FBox rootBox = _octree->GetRootBounds().GetBox();
+	if (rootBox.IsInside(bbox)) return;
+
+	// the octree cannot grow, rebuild it with bounds that also contain the new region
+	FBox newBounds = rootBox + bbox;
+	_octree = MakeUnique<TCoverPointOctree>(newBounds.GetCenter(), newBounds.GetExtent().GetMax());
+	store.ForEachHandle([&](int32 handle)
+	{
+		_octree->AddElement(FCoverPointOctreeElement(handle, store.GetLocation(handle), _elementExtent, &_elementIds));
+	});
+}
+
+void FCoverPointOctreeIndex::Compact()
+{
+	_octree->ShrinkElements();
+}
+
+/*
+---------- Uniform grid ------------
+*/
+
+FCoverPointGridIndex::FCoverPointGridIndex(float cellSize)
+{
+	_cellSize = FMath::Max(cellSize, 1.0f);
+	_invCellSize = 1.0f / _cellSize;
+}
+
+void FCoverPointGridIndex::Add(int32 handle, const FVector& location)
+{
+	_cells.FindOrAdd(GetCellCoord(location)).Add(handle);
+}
+
+void FCoverPointGridIndex::Remove(int32 handle, const FVector& location)
+{
+	FIntPoint coord = GetCellCoord(location);
+	FCell* cell = _cells.Find(coord);
+	if (!cell) return;
+
+	cell->RemoveSingleSwap(handle, false);
+	if (cell->Num() == 0)
+	{
+		_cells.Remove(coord);
+	}
+}
+
+void FCoverPointGridIndex::Empty()
+{
+	_cells.Empty();
+}
+
+template<typename TFunc>
+void FCoverPointGridIndex::ForEachCellInBox(const FBox& bbox, TFunc func) const
+{
+	FIntPoint minCoord = GetCellCoord(bbox.Min);
+	FIntPoint maxCoord = GetCellCoord(bbox.Max);
+
+	// a box that spans more cells than there are occupied cells is cheaper to answer by visiting every cell
+	int64 numQueryCells = int64(maxCoord.X - minCoord.X + 1) * int64(maxCoord.Y - minCoord.Y + 1);
+	if (numQueryCells > _cells.Num())
+	{
+		for (const TPair<FIntPoint, FCell>& cell : _cells)
+		{
+			if (cell.Key.X < minCoord.X || cell.Key.X > maxCoord.X || cell.Key.Y < minCoord.Y || cell.Key.Y > maxCoord.Y) continue;
+			func(cell.Value);
+		}
+		return;
+	}
+
+	for (int32 x = minCoord.X; x <= maxCoord.X; x++)
+	{
+		for (int32 y = minCoord.Y; y <= maxCoord.Y; y++)
+		{
+			if (const FCell* cell = _cells.Find(FIntPoint(x, y))) func(*cell);
+		}
+	}
+}
+
+void FCoverPointGridIndex::QueryBox(const FBox& bbox, const FCoverPointStore& store, TArray<int32>& outHandles) const
+{
+	ForEachCellInBox(bbox, [&](const FCell& cell)
+	{
+		for (int32 handle : cell)
+		{
+			if (FMath::PointBoxIntersection(store.GetLocation(handle), bbox)) outHandles.Add(handle);
+		}
+	});
+}
+
+void FCoverPointGridIndex::QueryBoxes(TArrayView<const FBox> boxes, const FCoverPointStore& store, FCoverPointQueryBuffer& buffer) const
+{
+	buffer.Begin(store.GetMaxHandle());
+
+	// cells shared by overlapping boxes are visited once per box, the buffer drops the duplicates
+	for (const FBox& bbox : boxes)
+	{
+		ForEachCellInBox(bbox, [&](const FCell& cell)
+		{
+			for (int32 handle : cell)
+			{
+				if (FMath::PointBoxIntersection(store.GetLocation(handle), bbox)) buffer.TryAdd(handle);
+			}
+		});
+	}
+
+	buffer.End();
+}
+
+bool FCoverPointGridIndex::HasPointWithin(const FVector& position, float radius, const FCoverPointStore& store, uint8 profiles) const
+{
+	FIntPoint minCoord = GetCellCoord(position - FVector(radius));
+	FIntPoint maxCoord = GetCellCoord(position + FVector(radius));
+	const float radiusSq = radius * radius;
+
+	for (int32 x = minCoord.X; x <= maxCoord.X; x++)
+	{
+		for (int32 y = minCoord.Y; y <= maxCoord.Y; y++)
+		{
+			const FCell* cell = _cells.Find(FIntPoint(x, y));
+			if (!cell) continue;
+
+			for (int32 handle : *cell)
+			{
+				if ((store.GetProfiles(handle) & profiles) != 0 && FVector::DistSquared(store.GetLocation(handle), position) < radiusSq) return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void FCoverPointGridIndex::Compact()
+{
+	_cells.Compact();
+}
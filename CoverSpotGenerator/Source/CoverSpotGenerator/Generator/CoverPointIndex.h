@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverDataStructures.h"
+#include "CoverPointStore.h"
+
+#include "CoverPointIndex.generated.h"
+
+UENUM()
+enum class ECoverPointIndexType : uint8
+{
+	Octree,
+	UniformGrid // spatial hash of vertical columns, the cell size follows the minimum cover point distance
+};
+
+// Caller-owned result buffer of batched cover point queries. The buffer keeps its allocations, so reusing it avoids allocations per query.
+struct FCoverPointQueryBuffer
+{
+	TArray<int32> _handles; // found cover points, without duplicates
+
+	// prepares the buffer for a query on a store with handles up to maxHandle
+	FORCEINLINE void Begin(int32 maxHandle)
+	{
+		_handles.Reset();
+		if (_visited.Num() < maxHandle) _visited.Add(false, maxHandle - _visited.Num());
+	}
+
+	FORCEINLINE void TryAdd(int32 handle)
+	{
+		if (_visited[handle]) return;
+		_visited[handle] = true;
+		_handles.Add(handle);
+	}
+
+	// only the bits of the found handles were set, clearing them is enough for the next query
+	FORCEINLINE void End()
+	{
+		for (int32 handle : _handles) _visited[handle] = false;
+	}
+
+private:
+	TBitArray<> _visited; // by handle
+};
+
+/**
+ * Spatial index over the handles of a cover point store. Locations are read from the store, the index only keeps the
+ * data it needs to find handles quickly.
+ */
+class COVERSPOTGENERATOR_API FCoverPointIndex
+{
+public:
+	virtual ~FCoverPointIndex() { }
+
+	static TUniquePtr<FCoverPointIndex> Create(ECoverPointIndexType type, const FBox& bounds, float elementExtent, float cellSize);
+
+	virtual ECoverPointIndexType GetType() const = 0;
+	virtual void Add(int32 handle, const FVector& location) = 0;
+	virtual void Remove(int32 handle, const FVector& location) = 0;
+	virtual void Empty() = 0;
+
+	// appends the handles of all points located inside the bbox
+	virtual void QueryBox(const FBox& bbox, const FCoverPointStore& store, TArray<int32>& outHandles) const = 0;
+
+	// Appends the handles of all points located inside any of the boxes, in a single pass over the index. Points inside
+	// multiple boxes are only added once.
+	virtual void QueryBoxes(TArrayView<const FBox> boxes, const FCoverPointStore& store, FCoverPointQueryBuffer& buffer) const = 0;
+
+	// true if a point of any of the agent profiles is located closer than radius to the position
+	virtual bool HasPointWithin(const FVector& position, float radius, const FCoverPointStore& store, uint8 profiles = AllCoverAgentProfiles) const = 0;
+
+	// makes sure points inside the bbox can be added, may rebuild the index from the store
+	virtual void EnsureBounds(const FBox& bbox, const FCoverPointStore& store) { }
+
+	// called after a generation pass, releases slack memory
+	virtual void Compact() { }
+};
+
+class COVERSPOTGENERATOR_API FCoverPointOctreeIndex : public FCoverPointIndex
+{
+public:
+	FCoverPointOctreeIndex(const FBox& bounds, float elementExtent);
+
+	virtual ECoverPointIndexType GetType() const override { return ECoverPointIndexType::Octree; }
+	virtual void Add(int32 handle, const FVector& location) override;
+	virtual void Remove(int32 handle, const FVector& location) override;
+	virtual void Empty() override;
+	virtual void QueryBox(const FBox& bbox, const FCoverPointStore& store, TArray<int32>& outHandles) const override;
+	virtual void QueryBoxes(TArrayView<const FBox> boxes, const FCoverPointStore& store, FCoverPointQueryBuffer& buffer) const override;
+	virtual bool HasPointWithin(const FVector& position, float radius, const FCoverPointStore& store, uint8 profiles = AllCoverAgentProfiles) const override;
+	virtual void EnsureBounds(const FBox& bbox, const FCoverPointStore& store) override;
+	virtual void Compact() override;
+
+private:
+	TUniquePtr<TCoverPointOctree> _octree;
+	TArray<FOctreeElementId> _elementIds; // by handle
+	float _elementExtent;
+};
+
+class COVERSPOTGENERATOR_API FCoverPointGridIndex : public FCoverPointIndex
+{
+public:
+	FCoverPointGridIndex(float cellSize);
+
+	virtual ECoverPointIndexType GetType() const override { return ECoverPointIndexType::UniformGrid; }
+	virtual void Add(int32 handle, const FVector& location) override;
+	virtual void Remove(int32 handle, const FVector& location) override;
+	virtual void Empty() override;
+	virtual void QueryBox(const FBox& bbox, const FCoverPointStore& store, TArray<int32>& outHandles) const override;
+	virtual void QueryBoxes(TArrayView<const FBox> boxes, const FCoverPointStore& store, FCoverPointQueryBuffer& buffer) const override;
+	virtual bool HasPointWithin(const FVector& position, float radius, const FCoverPointStore& store, uint8 profiles = AllCoverAgentProfiles) const override;
+	virtual void Compact() override;
+
+private:
+	typedef TArray<int32, TInlineAllocator<4>> FCell;
+
+	// calls func(cell) for every occupied cell overlapping the bbox
+	template<typename TFunc>
+	void ForEachCellInBox(const FBox& bbox, TFunc func) const;
+
+	FORCEINLINE FIntPoint GetCellCoord(const FVector& location) const
+	{
+		return FIntPoint(FMath::FloorToInt(location.X * _invCellSize), FMath::FloorToInt(location.Y * _invCellSize));
+	}
+
+	TMap<FIntPoint, FCell> _cells;
+	float _cellSize;
+	float _invCellSize;
+};
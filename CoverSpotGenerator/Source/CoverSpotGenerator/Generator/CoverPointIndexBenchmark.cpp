@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "CoverPointIndex.h"
+#include "CoverPointStore.h"
+
+/**
+ * Compares the cover point indices on synthetic data: insertion, dedup probes and radius queries.
+ * Usage: CoverGen.BenchmarkIndex [numPoints...], defaults to 10k, 100k and 1M points.
+ */
+
+// same defaults as the generator
+static const float BenchmarkMinDistance = 50.0f;
+static const float BenchmarkElementExtent = 150.0f;
+static const float BenchmarkQueryExtent = 1000.0f;
+static const float BenchmarkPointSpacing = 100.0f; // average area per point is spacing^2, keeps the density equal for all sizes
+static const int32 BenchmarkNumQueries = 1000;
+
+static void RunIndexBenchmark(ECoverPointIndexType type, const TArray<FVector>& locations, const TArray<FVector>& probes, const FBox& bounds)
+{
+	FCoverPointStore store;
+	TUniquePtr<FCoverPointIndex> index = FCoverPointIndex::Create(type, bounds, BenchmarkElementExtent, BenchmarkMinDistance);
+
+	double startTime = FPlatformTime::Seconds();
+	for (const FVector& location : locations)
+	{
+		int32 handle = store.Add(location, FVector::ForwardVector, FVector::ZeroVector, 0, 0.0f, AllCoverAgentProfiles);
+		index->Add(handle, location);
+	}
+	index->Compact();
+	double insertTime = FPlatformTime::Seconds() - startTime;
+
+	startTime = FPlatformTime::Seconds();
+	int32 numDuplicates = 0;
+	for (const FVector& probe : probes)
+	{
+		if (index->HasPointWithin(probe, BenchmarkMinDistance, store)) numDuplicates++;
+	}
+	double probeTime = FPlatformTime::Seconds() - startTime;
+
+	startTime = FPlatformTime::Seconds();
+	TArray<int32> handles;
+	int64 numFound = 0;
+	for (int32 queryIdx = 0; queryIdx < BenchmarkNumQueries; queryIdx++)
+	{
+		const FVector& center = probes[queryIdx % probes.Num()];
+		handles.Reset();
+		index->QueryBox(FBox(center - FVector(BenchmarkQueryExtent), center + FVector(BenchmarkQueryExtent)), store, handles);
+		numFound += handles.Num();
+	}
+	double queryTime = FPlatformTime::Seconds() - startTime;
+
+	UE_LOG(LogTemp, Log, TEXT("%s, %d points: insert %.2f ms, %d dedup probes %.2f ms (%d hits), %d radius queries %.2f ms (%lld points)"),
+		type == ECoverPointIndexType::Octree ? TEXT("Octree") : TEXT("Uniform grid"), locations.Num(), insertTime * 1000.0,
+		probes.Num(), probeTime * 1000.0, numDuplicates, BenchmarkNumQueries, queryTime * 1000.0, numFound);
+}
+
+static void BenchmarkCoverPointIndex(const TArray<FString>& args)
+{
+	TArray<int32> sizes;
+	for (const FString& arg : args)
+	{
+		int32 size = FCString::Atoi(*arg);
+		if (size > 0) sizes.Add(size);
+	}
+	if (sizes.Num() == 0)
+	{
+		sizes = { 10000, 100000, 1000000 };
+	}
+
+	for (int32 numPoints : sizes)
+	{
+		// points are spread over a square with a few floors, like cover points of a large level
+		FRandomStream random(numPoints);
+		const float size = FMath::Sqrt((float)numPoints) * BenchmarkPointSpacing;
+		const FBox bounds(FVector(0.0f, 0.0f, 0.0f), FVector(size, size, 1200.0f));
+
+		TArray<FVector> locations;
+		locations.Reserve(numPoints);
+		for (int32 idx = 0; idx < numPoints; idx++)
+		{
+			locations.Emplace(random.FRandRange(0.0f, size), random.FRandRange(0.0f, size), random.RandRange(0, 3) * 400.0f);
+		}
+
+		TArray<FVector> probes;
+		probes.Reserve(numPoints);
+		for (int32 idx = 0; idx < numPoints; idx++)
+		{
+			probes.Emplace(random.FRandRange(0.0f, size), random.FRandRange(0.0f, size), random.RandRange(0, 3) * 400.0f);
+		}
+
+		RunIndexBenchmark(ECoverPointIndexType::Octree, locations, probes, bounds);
+		RunIndexBenchmark(ECoverPointIndexType::UniformGrid, locations, probes, bounds);
+	}
+}
+
+static FAutoConsoleCommand BenchmarkCoverPointIndexCommand(
+	TEXT("CoverGen.BenchmarkIndex"),
+	TEXT("Benchmarks the octree and uniform grid cover point indices. Arguments: list of point counts."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCoverPointIndex));
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverPointKernels.h"
+
+// cosine of the angle of four points, shared by the full groups and the padded tail so a point's score does not depend on its position
+static FORCEINLINE VectorRegister CosAngleToTarget4(const float* x, const float* y, const float* z, const float* dirX, const float* dirY, const float* dirZ,
+	const VectorRegister& targetX, const VectorRegister& targetY, const VectorRegister& targetZ)
+{
+	VectorRegister toTargetX = VectorSubtract(targetX, VectorLoad(x));
+	VectorRegister toTargetY = VectorSubtract(targetY, VectorLoad(y));
+	VectorRegister toTargetZ = VectorSubtract(targetZ, VectorLoad(z));
+
+	// dot(dir, toTarget) / |toTarget|, the direction itself is normalized
+	VectorRegister lengthSq = VectorMultiplyAdd(toTargetZ, toTargetZ, VectorMultiplyAdd(toTargetY, toTargetY, VectorMultiply(toTargetX, toTargetX)));
+	VectorRegister invLength = VectorReciprocalSqrtAccurate(VectorMax(lengthSq, VectorSetFloat1(SMALL_NUMBER)));
+
+	VectorRegister dot = VectorMultiply(VectorLoad(dirX), toTargetX);
+	dot = VectorMultiplyAdd(VectorLoad(dirY), toTargetY, dot);
+	dot = VectorMultiplyAdd(VectorLoad(dirZ), toTargetZ, dot);
+
+	return VectorMultiply(dot, invLength);
+}
+
+void CoverPointKernels::CosAngleToTarget(const FCoverPackedVectors& points, const FCoverPackedVectors& directions, const FVector& target, float* outCosAngle)
+{
+	check(points._num == directions._num);
+
+	const VectorRegister targetX = VectorSetFloat1(target.X);
+	const VectorRegister targetY = VectorSetFloat1(target.Y);
+	const VectorRegister targetZ = VectorSetFloat1(target.Z);
+
+	int32 idx = 0;
+	for (; idx + 4 <= points._num; idx += 4)
+	{
+		VectorRegister cosAngle = CosAngleToTarget4(points._x + idx, points._y + idx, points._z + idx, directions._x + idx, directions._y + idx, directions._z + idx,
+			targetX, targetY, targetZ);
+		VectorStore(cosAngle, outCosAngle + idx);
+	}
+
+	// remaining points, padded to a group of four
+	const int32 numRemaining = points._num - idx;
+	if (numRemaining > 0)
+	{
+		float tail[7][4] = {};
+		const float* sources[6] = { points._x, points._y, points._z, directions._x, directions._y, directions._z };
+		for (int32 component = 0; component < 6; component++)
+		{
+			FMemory::Memcpy(tail[component], sources[component] + idx, numRemaining * sizeof(float));
+		}
+
+		VectorStore(CosAngleToTarget4(tail[0], tail[1], tail[2], tail[3], tail[4], tail[5], targetX, targetY, targetZ), tail[6]);
+		FMemory::Memcpy(outCosAngle + idx, tail[6], numRemaining * sizeof(float));
+	}
+}
+
+void CoverPointKernels::LinearStep(const float* values, int32 num, float from, float to, float* outValues)
+{
+	const float invRange = 1.0f / (FMath::Abs(to - from) > SMALL_NUMBER ? to - from : SMALL_NUMBER);
+	const VectorRegister fromVec = VectorSetFloat1(from);
+	const VectorRegister invRangeVec = VectorSetFloat1(invRange);
+
+	int32 idx = 0;
+	for (; idx + 4 <= num; idx += 4)
+	{
+		VectorRegister step = VectorMultiply(VectorSubtract(VectorLoad(values + idx), fromVec), invRangeVec);
+		VectorStore(VectorMin(VectorMax(step, VectorZero()), VectorOne()), outValues + idx);
+	}
+
+	// remaining values
+	for (; idx < num; idx++)
+	{
+		outValues[idx] = FMath::Clamp((values[idx] - from) * invRange, 0.0f, 1.0f);
+	}
+}
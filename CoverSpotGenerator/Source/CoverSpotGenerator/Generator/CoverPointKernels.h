@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// X/Y/Z components of a number of vectors, each stored in its own packed array
+struct FCoverPackedVectors
+{
+	FCoverPackedVectors(const float* x, const float* y, const float* z, int32 num) : _x(x), _y(y), _z(z), _num(num) { }
+
+	const float* _x;
+	const float* _y;
+	const float* _z;
+	int32 _num;
+};
+
+/**
+ * Vectorized kernels that process four cover points per instruction. They work on packed arrays gathered for a batch of
+ * candidates, see FEnvQueryCoverPointBatch. Angles are compared in cosine space.
+ */
+namespace CoverPointKernels
+{
+	// cosine of the angle between every direction and the direction from its point to the target
+	COVERSPOTGENERATOR_API void CosAngleToTarget(const FCoverPackedVectors& points, const FCoverPackedVectors& directions, const FVector& target, float* outCosAngle);
+
+	// clamp((value - from) / (to - from), 0, 1) of every value, from and to may be in either order
+	COVERSPOTGENERATOR_API void LinearStep(const float* values, int32 num, float from, float to, float* outValues);
+}
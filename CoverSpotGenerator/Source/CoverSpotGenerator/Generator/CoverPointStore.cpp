@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverPointStore.h"
+
+int32 FCoverPointStore::Add(const FVector& location, const FVector& dirToCover, const FVector& leanDirection, uint8 flags, float obstacleHeight, uint8 profiles)
+{
+	int32 handle;
+	if (_freeHandles.Num() > 0)
+	{
+		handle = _freeHandles.Pop(false);
+		_allocated[handle] = true;
+	}
+	else
+	{
+		handle = _allocated.Add(true);
+		_posX.AddUninitialized(); _posY.AddUninitialized(); _posZ.AddUninitialized();
+		_dirX.AddUninitialized(); _dirY.AddUninitialized(); _dirZ.AddUninitialized();
+		_leanX.AddUninitialized(); _leanY.AddUninitialized(); _leanZ.AddUninitialized();
+		_flags.AddUninitialized();
+		_obstacleHeight.AddUninitialized();
+		_profiles.AddUninitialized();
+	}
+
+	_posX[handle] = location.X; _posY[handle] = location.Y; _posZ[handle] = location.Z;
+	_dirX[handle] = dirToCover.X; _dirY[handle] = dirToCover.Y; _dirZ[handle] = dirToCover.Z;
+	_leanX[handle] = leanDirection.X; _leanY[handle] = leanDirection.Y; _leanZ[handle] = leanDirection.Z;
+	_flags[handle] = flags;
+	_obstacleHeight[handle] = obstacleHeight;
+	_profiles[handle] = profiles;
+	_num++;
+
+	return handle;
+}
+
+void FCoverPointStore::Remove(int32 handle)
+{
+	if (!IsValidHandle(handle)) return;
+
+	_allocated[handle] = false;
+	_flags[handle] = 0;
+	_profiles[handle] = 0;
+	_freeHandles.Add(handle);
+	_num--;
+}
+
+void FCoverPointStore::Empty()
+{
+	_posX.Empty(); _posY.Empty(); _posZ.Empty();
+	_dirX.Empty(); _dirY.Empty(); _dirZ.Empty();
+	_leanX.Empty(); _leanY.Empty(); _leanZ.Empty();
+	_flags.Empty();
+	_obstacleHeight.Empty();
+	_profiles.Empty();
+	_allocated.Empty();
+	_freeHandles.Empty();
+	_num = 0;
+}
+
+void FCoverPointStore::Shrink()
+{
+	_posX.Shrink(); _posY.Shrink(); _posZ.Shrink();
+	_dirX.Shrink(); _dirY.Shrink(); _dirZ.Shrink();
+	_leanX.Shrink(); _leanY.Shrink(); _leanZ.Shrink();
+	_flags.Shrink();
+	_obstacleHeight.Shrink();
+	_profiles.Shrink();
+	_freeHandles.Shrink();
+}
+
+void FCoverPointStore::Serialize(FArchive& ar)
+{
+	_posX.BulkSerialize(ar); _posY.BulkSerialize(ar); _posZ.BulkSerialize(ar);
+	_dirX.BulkSerialize(ar); _dirY.BulkSerialize(ar); _dirZ.BulkSerialize(ar);
+	_leanX.BulkSerialize(ar); _leanY.BulkSerialize(ar); _leanZ.BulkSerialize(ar);
+	_flags.BulkSerialize(ar);
+	_obstacleHeight.BulkSerialize(ar);
+	_profiles.BulkSerialize(ar);
+	ar << _allocated;
+	ar << _freeHandles;
+	ar << _num;
+
+	// reject inconsistent data, e.g. from a corrupted file
+	if (ar.IsLoading())
+	{
+		const int32 numSlots = _allocated.Num();
+		bool consistent = _posX.Num() == numSlots && _posY.Num() == numSlots && _posZ.Num() == numSlots
+			&& _dirX.Num() == numSlots && _dirY.Num() == numSlots && _dirZ.Num() == numSlots
+			&& _leanX.Num() == numSlots && _leanY.Num() == numSlots && _leanZ.Num() == numSlots && _flags.Num() == numSlots && _obstacleHeight.Num() == numSlots
+			&& _profiles.Num() == numSlots;
+		if (!consistent)
+		{
+			ar.SetError();
+			Empty();
+		}
+	}
+}
+
+FCoverPointData FCoverPointStore::Get(int32 handle) const
+{
+	FCoverPointData point;
+	point._location = GetLocation(handle);
+	point._dirToCover = GetDirToCover(handle);
+	point._leanDirection = GetLeanDirection(handle);
+	point._flags = _flags[handle];
+	point._obstacleHeight = _obstacleHeight[handle];
+	point._profiles = _profiles[handle];
+	point._handle = handle;
+
+	return point;
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverDataStructures.h"
+
+/**
+ * Structure-of-arrays storage of all cover points. Every component of the location, the direction to the cover and the
+ * lean direction lives in its own packed array. Points are found through the spatial index, the store has no filters of its own.
+ * The slot of a point is its handle, removed slots are reused by later points.
+ */
+class COVERSPOTGENERATOR_API FCoverPointStore
+{
+public:
+	int32 Add(const FVector& location, const FVector& dirToCover, const FVector& leanDirection, uint8 flags, float obstacleHeight, uint8 profiles);
+	void Remove(int32 handle);
+	void Empty();
+	void Shrink();
+	void Serialize(FArchive& ar); // keeps the slot layout, so handles stay the same after loading
+
+	FORCEINLINE bool IsValidHandle(int32 handle) const { return handle >= 0 && handle < _allocated.Num() && _allocated[handle]; }
+	FORCEINLINE int32 Num() const { return _num; }
+	FORCEINLINE int32 GetMaxHandle() const { return _allocated.Num(); } // all handles are smaller than this
+
+	FORCEINLINE FVector GetLocation(int32 handle) const { return FVector(_posX[handle], _posY[handle], _posZ[handle]); }
+	FORCEINLINE FVector GetDirToCover(int32 handle) const { return FVector(_dirX[handle], _dirY[handle], _dirZ[handle]); }
+	FORCEINLINE FVector GetLeanDirection(int32 handle) const { return FVector(_leanX[handle], _leanY[handle], _leanZ[handle]); }
+	FORCEINLINE uint8 GetFlags(int32 handle) const { return _flags[handle]; }
+	FORCEINLINE float GetObstacleHeight(int32 handle) const { return _obstacleHeight[handle]; }
+	FORCEINLINE uint8 GetProfiles(int32 handle) const { return _profiles[handle]; }
+	FCoverPointData Get(int32 handle) const;
+
+	// calls func(handle) for every stored cover point
+	template<typename TFunc>
+	FORCEINLINE void ForEachHandle(TFunc func) const
+	{
+		for (TConstSetBitIterator<> it(_allocated); it; ++it) func(it.GetIndex());
+	}
+
+private:
+	TArray<float> _posX;
+	TArray<float> _posY;
+	TArray<float> _posZ;
+	TArray<float> _dirX;
+	TArray<float> _dirY;
+	TArray<float> _dirZ;
+	TArray<float> _leanX;
+	TArray<float> _leanY;
+	TArray<float> _leanZ;
+	TArray<uint8> _flags; // ECoverPointFlags
+	TArray<float> _obstacleHeight;
+	TArray<uint8> _profiles; // agent profile mask
+
+	TBitArray<> _allocated;
+	TArray<int32> _freeHandles;
+	int32 _num = 0;
+};
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverRaycaster.h"
+
+#include "Stats/Stats.h"
+
+FThreadSafeCounter64 FCoverRaycastBatch::TotalNumTraces;
+
+void FCoverRaycastBatch::Execute(ICoverRaycaster& raycaster)
+{
+	const int32 numTraces = _starts.Num();
+	_hits.SetNum(numTraces);
+	TotalNumTraces.Add(numTraces);
+#if STATS
+	if (!_traceStat.IsNone()) INC_DWORD_STAT_BY_FName(_traceStat, numTraces);
+#endif
+
+	raycaster.Raycast(_starts, _ends, _hits);
+}
+
+void FCoverRaycastBatch::ExecuteCounted(ICoverRaycaster& raycaster, int32 maxCount)
+{
+	const int32 numTraces = _starts.Num();
+	_numHits.SetNum(numTraces);
+	TotalNumTraces.Add(numTraces);
+#if STATS
+	if (!_traceStat.IsNone()) INC_DWORD_STAT_BY_FName(_traceStat, numTraces);
+#endif
+
+	raycaster.CountHits(_starts, _ends, maxCount, _numHits);
+}
+
+void FCoverRaycastBatch::Reset()
+{
+	_starts.Reset();
+	_ends.Reset();
+	_hits.Reset();
+	_numHits.Reset();
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class AActor;
+
+// first blocking hit of a raycast
+struct FCoverRaycastHit
+{
+	FVector _location = FVector::ZeroVector;
+	FVector _normal = FVector::ZeroVector; // normal of the traced shape
+	FVector _impactNormal = FVector::ZeroVector; // normal of the surface that was hit
+	float _distance = 0.0f;
+	bool _blockingHit = false;
+	TWeakObjectPtr<AActor> _actor; // only set by raycasters that trace against a world
+};
+
+/**
+ * Line trace backend of the cover generation. The generator traces against the world, offline tools and benchmarks can trace
+ * against their own geometry. Implementations may spread a batch over worker threads, but must return once all hits are written.
+ */
+class COVERSPOTGENERATOR_API ICoverRaycaster
+{
+public:
+	virtual ~ICoverRaycaster() { }
+
+	// traces every segment starts[i] -> ends[i], outHits has the same size as starts when called
+	virtual void Raycast(const TArray<FVector>& starts, const TArray<FVector>& ends, TArray<FCoverRaycastHit>& outHits) = 0;
+
+	// Counts the obstacles on every segment starts[i] -> ends[i], every obstacle once however thick it is. Stops counting a segment as soon
+	// as maxCount is exceeded and then reports maxCount + 1. outNumHits has the same size as starts when called.
+	virtual void CountHits(const TArray<FVector>& starts, const TArray<FVector>& ends, int32 maxCount, TArray<int32>& outNumHits) = 0;
+};
+
+/**
+ * Collects the line traces of one generation stage or one EQS test window so they can be executed together by a raycaster. Results
+ * are read back by the index returned when adding a trace.
+ */
+class COVERSPOTGENERATOR_API FCoverRaycastBatch
+{
+public:
+	FORCEINLINE int32 Add(const FVector& start, const FVector& end)
+	{
+		_starts.Emplace(start);
+		return _ends.Emplace(end);
+	}
+
+	FORCEINLINE const FCoverRaycastHit& GetHit(int32 traceIdx) const { return _hits[traceIdx]; }
+	FORCEINLINE int32 GetNumHits(int32 traceIdx) const { return _numHits[traceIdx]; }
+	FORCEINLINE int32 Num() const { return _starts.Num(); }
+
+	void Execute(ICoverRaycaster& raycaster);
+	// counts the obstacles of every trace instead of finding its first hit, read back with GetNumHits
+	void ExecuteCounted(ICoverRaycaster& raycaster, int32 maxCount);
+	void Reset();
+
+#if STATS
+	// accumulator that counts the executed traces, see SET_COVERGEN_TRACE_STAT
+	FORCEINLINE void SetTraceStat(FName statName) { _traceStat = statName; }
+#endif
+
+	// number of traces all batches executed since startup, for benchmarks
+	static int64 GetTotalNumTraces() { return TotalNumTraces.GetValue(); }
+
+private:
+	static FThreadSafeCounter64 TotalNumTraces;
+
+	TArray<FVector> _starts;
+	TArray<FVector> _ends;
+	TArray<FCoverRaycastHit> _hits;
+	TArray<int32> _numHits;
+#if STATS
+	FName _traceStat;
+#endif
+};
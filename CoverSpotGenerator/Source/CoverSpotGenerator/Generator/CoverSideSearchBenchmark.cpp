@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "CoverGenerationCore.h"
+#include "CoverBoxBVHRaycaster.h"
+
+/**
+ * Compares the linear and the adaptive obstacle side search on synthetic box obstacles, traced without a world: traces per corner,
+ * corners found and placement error of the side points.
+ * Usage: CoverGen.BenchmarkSideSearch [numObstacles] [tolerance], defaults to 1000 obstacles and the generator's tolerance.
+ */
+
+static const float BenchmarkObstacleSpacing = 1500.0f; // obstacles are placed along X, one per spacing
+static const float BenchmarkObstacleHeight = 200.0f;
+static const float BenchmarkEdgeOffset = 40.0f; // distance of the nav edge to the obstacle face, like an agent radius
+static const float BenchmarkMaxCornerDistance = 150.0f; // nav vertices end up to this far before or behind the obstacle corner
+
+static void RunSideSearchBenchmark(ECoverSideSearchMode mode, float tolerance, FCoverBoxBVHRaycaster& raycaster, const TArray<FBox>& obstacles,
+	const TArray<FVector>& vertices, const TArray<FCoverNavEdge>& navEdges)
+{
+	FCoverGenerationParams params;
+	params._sideSearchMode = mode;
+	if (tolerance > 0.0f) params._sideSearchTolerance = tolerance;
+	FCoverGenerationCore core(params, raycaster);
+
+	double startTime = FPlatformTime::Seconds();
+	TArray<FVector> sidePoints;
+	int64 numTraces = core.SearchObstacleSides(vertices, navEdges, sidePoints);
+	double searchTime = FPlatformTime::Seconds() - startTime;
+
+	// a side point should keep a clearance of _coverPointOffset to the corner of its obstacle
+	double totalError = 0.0;
+	float maxError = 0.0f;
+	for (const FVector& sidePoint : sidePoints)
+	{
+		int32 obstacleIdx = FMath::Clamp(FMath::RoundToInt(sidePoint.X / BenchmarkObstacleSpacing), 0, obstacles.Num() - 1);
+		const FBox& obstacle = obstacles[obstacleIdx];
+		float error = FMath::Min(FMath::Abs(sidePoint.X - (obstacle.Min.X + params._coverPointOffset)), FMath::Abs(sidePoint.X - (obstacle.Max.X - params._coverPointOffset)));
+
+		totalError += error;
+		maxError = FMath::Max(maxError, error);
+	}
+
+	const int32 numCorners = navEdges.Num() * 2;
+	UE_LOG(LogTemp, Log, TEXT("%s side search: %d of %d corners found, %.2f traces per corner, placement error avg %.2f max %.2f, %.2f ms"),
+		mode == ECoverSideSearchMode::Linear ? TEXT("Linear") : TEXT("Adaptive"), sidePoints.Num(), numCorners, (double)numTraces / numCorners,
+		sidePoints.Num() > 0 ? totalError / sidePoints.Num() : 0.0, maxError, searchTime * 1000.0);
+}
+
+static void BenchmarkCoverSideSearch(const TArray<FString>& args)
+{
+	int32 numObstacles = args.Num() > 0 ? FMath::Max(FCString::Atoi(*args[0]), 1) : 1000;
+	float tolerance = args.Num() > 1 ? FCString::Atof(*args[1]) : 0.0f;
+
+	// box obstacles of random width and depth on a floor, every obstacle has a nav edge along its front face whose vertices
+	// end before or behind the corners, like the edges of a nav mesh around obstacles of any size
+	FRandomStream random(numObstacles);
+	FCoverBoxBVHRaycaster raycaster;
+	raycaster.AddBox(FBox(FVector(-BenchmarkObstacleSpacing, -5000.0f, -10.0f), FVector(numObstacles * BenchmarkObstacleSpacing, 5000.0f, 0.0f)));
+
+	TArray<FBox> obstacles;
+	TArray<FVector> vertices;
+	TArray<FCoverNavEdge> navEdges;
+	for (int32 obstacleIdx = 0; obstacleIdx < numObstacles; obstacleIdx++)
+	{
+		const float halfWidth = random.FRandRange(50.0f, 300.0f);
+		const float depth = random.FRandRange(20.0f, 200.0f);
+		const float centerX = obstacleIdx * BenchmarkObstacleSpacing;
+		FBox obstacle(FVector(centerX - halfWidth, 0.0f, 0.0f), FVector(centerX + halfWidth, depth, BenchmarkObstacleHeight));
+		obstacles.Add(obstacle);
+		raycaster.AddBox(obstacle);
+
+		// the obstacle is on the right of the edge, the face search traces towards it
+		const float edgeY = -BenchmarkEdgeOffset;
+		int32 v1 = vertices.Emplace(obstacle.Min.X - random.FRandRange(-BenchmarkMaxCornerDistance, BenchmarkMaxCornerDistance), edgeY, 0.0f);
+		int32 v2 = vertices.Emplace(obstacle.Max.X + random.FRandRange(-BenchmarkMaxCornerDistance, BenchmarkMaxCornerDistance), edgeY, 0.0f);
+		if (vertices[v2].X - vertices[v1].X < 20.0f)
+		{
+			vertices[v1].X = centerX - 10.0f;
+			vertices[v2].X = centerX + 10.0f;
+		}
+		navEdges.Emplace(v1, v2, AllCoverAgentProfiles);
+	}
+	raycaster.Build();
+
+	RunSideSearchBenchmark(ECoverSideSearchMode::Linear, tolerance, raycaster, obstacles, vertices, navEdges);
+	RunSideSearchBenchmark(ECoverSideSearchMode::Adaptive, tolerance, raycaster, obstacles, vertices, navEdges);
+}
+
+static FAutoConsoleCommand BenchmarkCoverSideSearchCommand(
+	TEXT("CoverGen.BenchmarkSideSearch"),
+	TEXT("Compares the linear and adaptive obstacle side search on synthetic obstacles. Arguments: number of obstacles, adaptive tolerance."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCoverSideSearch));
@@ -6,5 +6,7 @@
 
 void CoverSpotGeneratorAsync::DoWork()
 {
-	_cpg->_Initialize(_generationBBox);
-}
\ No newline at end of file
+	_cpg->_Initialize(*_job);
+	_cpg->CompleteGenerationJob(_job);
+	_cpg->_numRunningJobs.Decrement();
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Async/AsyncWork.h"
+#include "CoverGenerationJob.h"
 
 /**
  * 
@@ -14,10 +15,10 @@ class COVERSPOTGENERATOR_API CoverSpotGeneratorAsync : public FNonAbandonableTas
 
 private:
 	class ACoverPointGenerator* _cpg;
-	FBox _generationBBox;
+	FCoverGenerationJobPtr _job;
 
 public:
-	CoverSpotGeneratorAsync(class ACoverPointGenerator* cpg, FBox genBBox) : _cpg(cpg), _generationBBox(genBBox) { }
+	CoverSpotGeneratorAsync(class ACoverPointGenerator* cpg, const FCoverGenerationJobPtr& job) : _cpg(cpg), _job(job) { }
 	~CoverSpotGeneratorAsync() {}
 
 	FORCEINLINE TStatId GetStatId() const
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "CoverWorldRaycaster.h"
+#include "CoverBoxBVHRaycaster.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A trace through a thick box with simple collision must count the box once, not once per step through its inside.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCoverCountHitsThickBoxTest, "CoverSpotGenerator.CountHits.ThickBox",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCoverCountHitsThickBoxTest::RunTest(const FString& Parameters)
+{
+	UStaticMesh* cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("Cube mesh"), cube)) return false;
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+
+	// the cube is 100 units wide, scaled to a box 300 units thick
+	AStaticMeshActor* box = world->SpawnActor<AStaticMeshActor>(FVector::ZeroVector, FRotator::ZeroRotator);
+	UStaticMeshComponent* boxMesh = box->GetStaticMeshComponent();
+	boxMesh->SetMobility(EComponentMobility::Movable);
+	boxMesh->SetStaticMesh(cube);
+	boxMesh->SetWorldScale3D(FVector(3.0f));
+
+	const int32 maxCount = 16;
+	TestEqual(TEXT("Hits through a thick box"), FCoverWorldRaycaster::CountHits(world, FVector(-500.0f, 0.0f, 0.0f), FVector(500.0f, 0.0f, 0.0f), maxCount), 1);
+	TestEqual(TEXT("Hits next to the box"), FCoverWorldRaycaster::CountHits(world, FVector(-500.0f, 500.0f, 0.0f), FVector(500.0f, 500.0f, 0.0f), maxCount), 0);
+
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+
+	return true;
+}
+
+// The box raycaster counts the same way, without a world.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCoverCountHitsThickBoxBVHTest, "CoverSpotGenerator.CountHits.ThickBoxBVH",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCoverCountHitsThickBoxBVHTest::RunTest(const FString& Parameters)
+{
+	FCoverBoxBVHRaycaster raycaster;
+	raycaster.AddBox(FBox(FVector(-150.0f), FVector(150.0f)));
+	raycaster.AddBox(FBox(FVector(200.0f, -150.0f, -150.0f), FVector(400.0f, 150.0f, 150.0f)));
+	raycaster.Build();
+
+	const int32 maxCount = 16;
+	TestEqual(TEXT("Hits through one thick box"), raycaster.CountHits(FVector(-500.0f, 0.0f, 0.0f), FVector(180.0f, 0.0f, 0.0f), maxCount), 1);
+	TestEqual(TEXT("Hits through two thick boxes"), raycaster.CountHits(FVector(-500.0f, 0.0f, 0.0f), FVector(500.0f, 0.0f, 0.0f), maxCount), 2);
+	TestEqual(TEXT("Hits next to the boxes"), raycaster.CountHits(FVector(-500.0f, 500.0f, 0.0f), FVector(500.0f, 500.0f, 0.0f), maxCount), 0);
+
+	return true;
+}
+
+#endif
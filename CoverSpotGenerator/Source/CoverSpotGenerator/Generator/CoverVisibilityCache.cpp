@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverVisibilityCache.h"
+
+void FCoverVisibilityCache::Init(float cellSize, float range)
+{
+	_cellSize = FMath::Max(cellSize, 100.0f);
+	_range = range;
+	_windowXY = FMath::CeilToInt(range / _cellSize);
+
+	const int32 windowSize = 2 * _windowXY + 1;
+	const int32 numWindowCells = windowSize * windowSize * (2 * WindowZ + 1);
+	_bytesPerPoint = (numWindowCells + 3) / 4;
+	_states.Reset();
+}
+
+void FCoverVisibilityCache::Reset()
+{
+	_cellSize = 0.0f;
+	_range = 0.0f;
+	_windowXY = 0;
+	_bytesPerPoint = 0;
+	_states.Empty();
+}
+
+void FCoverVisibilityCache::Clear(int32 handle)
+{
+	int32 offset = handle * _bytesPerPoint;
+	if (!IsInitialized() || offset >= _states.Num()) return;
+
+	FMemory::Memzero(_states.GetData() + offset, _bytesPerPoint);
+}
+
+void FCoverVisibilityCache::Set(int32 handle, int32 windowCellIdx, ECoverVisibility visibility)
+{
+	int32 requiredSize = (handle + 1) * _bytesPerPoint;
+	if (_states.Num() < requiredSize)
+	{
+		_states.AddZeroed(requiredSize - _states.Num());
+	}
+
+	uint8& state = _states[handle * _bytesPerPoint + windowCellIdx / 4];
+	int32 shift = (windowCellIdx % 4) * 2;
+	state = (state & ~(3 << shift)) | ((uint8)visibility << shift);
+}
+
+ECoverVisibility FCoverVisibilityCache::Get(int32 handle, const FVector& pointLocation, const FVector& targetLocation) const
+{
+	int32 offset = handle * _bytesPerPoint;
+	if (!IsInitialized() || offset >= _states.Num()) return ECoverVisibility::Unknown;
+
+	FIntVector delta = GetCellCoord(targetLocation) - GetCellCoord(pointLocation);
+	if (FMath::Abs(delta.X) > _windowXY || FMath::Abs(delta.Y) > _windowXY || FMath::Abs(delta.Z) > WindowZ) return ECoverVisibility::Unknown;
+
+	const int32 windowSize = 2 * _windowXY + 1;
+	int32 windowCellIdx = ((delta.Z + WindowZ) * windowSize + (delta.Y + _windowXY)) * windowSize + (delta.X + _windowXY);
+
+	uint8 state = _states[offset + windowCellIdx / 4];
+	return (ECoverVisibility)((state >> ((windowCellIdx % 4) * 2)) & 3);
+}
+
+void FCoverVisibilityCache::Serialize(FArchive& ar)
+{
+	ar << _cellSize << _range << _windowXY << _bytesPerPoint;
+	_states.BulkSerialize(ar);
+}
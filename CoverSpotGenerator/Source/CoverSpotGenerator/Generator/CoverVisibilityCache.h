@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// cached visibility between a cover point and a region cell
+enum class ECoverVisibility : uint8
+{
+	Unknown = 0, // not cached, a trace is needed
+	Hidden = 1, // the cover point's exposed positions cannot be seen from anywhere in the cell
+	Visible = 2, // one of the cover point's exposed positions can be seen from everywhere in the cell
+	Mixed = 3 // partly visible, a trace is needed
+};
+
+/**
+ * Potentially visible set between cover points and the coarse region cells around them, built from the static geometry at generation
+ * time. Every cover point has a window of cells centered on its own cell and stores 2 bits per window cell, cells outside of the window
+ * are Unknown. Points are addressed by their handle.
+ */
+class COVERSPOTGENERATOR_API FCoverVisibilityCache
+{
+public:
+	void Init(float cellSize, float range);
+	void Reset();
+	FORCEINLINE bool IsInitialized() const { return _bytesPerPoint > 0; }
+	FORCEINLINE bool Matches(float cellSize, float range) const { return _cellSize == cellSize && _range == range; }
+
+	void Clear(int32 handle);
+	void Set(int32 handle, int32 windowCellIdx, ECoverVisibility visibility);
+	ECoverVisibility Get(int32 handle, const FVector& pointLocation, const FVector& targetLocation) const;
+
+	// calls func(windowCellIdx, cellBounds) for every cell of the point's window that is within range of the point
+	template<typename TFunc>
+	void ForEachWindowCell(const FVector& pointLocation, TFunc func) const
+	{
+		FIntVector pointCell = GetCellCoord(pointLocation);
+		const int32 windowSize = 2 * _windowXY + 1;
+		const FVector cellExtent(_cellSize, _cellSize, CellHeight);
+
+		for (int32 dz = -WindowZ; dz <= WindowZ; dz++)
+		{
+			for (int32 dy = -_windowXY; dy <= _windowXY; dy++)
+			{
+				for (int32 dx = -_windowXY; dx <= _windowXY; dx++)
+				{
+					FVector cellMin = FVector(pointCell.X + dx, pointCell.Y + dy, pointCell.Z + dz) * cellExtent;
+					FBox cellBounds(cellMin, cellMin + cellExtent);
+					if (FVector::DistSquared(cellBounds.GetCenter(), pointLocation) > FMath::Square(_range)) continue;
+
+					int32 windowCellIdx = ((dz + WindowZ) * windowSize + (dy + _windowXY)) * windowSize + (dx + _windowXY);
+					func(windowCellIdx, cellBounds);
+				}
+			}
+		}
+	}
+
+	void Serialize(FArchive& ar);
+
+private:
+	// cells are flat, cover is mostly about threats on the same floor. The window only reaches one cell up and down.
+	static constexpr float CellHeight = 300.0f;
+	static constexpr int32 WindowZ = 1;
+
+	FORCEINLINE FIntVector GetCellCoord(const FVector& location) const
+	{
+		return FIntVector(FMath::FloorToInt(location.X / _cellSize), FMath::FloorToInt(location.Y / _cellSize), FMath::FloorToInt(location.Z / CellHeight));
+	}
+
+	float _cellSize = 0.0f;
+	float _range = 0.0f;
+	int32 _windowXY = 0; // half size of the window in cells
+	int32 _bytesPerPoint = 0;
+	TArray<uint8> _states; // 2 bits per window cell, _bytesPerPoint bytes per handle
+};
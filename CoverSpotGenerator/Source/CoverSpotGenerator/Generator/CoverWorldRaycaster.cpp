@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoverWorldRaycaster.h"
+
+#include "Engine/World.h"
+#include "Components/PrimitiveComponent.h"
+#include "Async/ParallelFor.h"
+
+void FCoverWorldRaycaster::Raycast(const TArray<FVector>& starts, const TArray<FVector>& ends, TArray<FCoverRaycastHit>& outHits)
+{
+	const int32 numTraces = starts.Num();
+
+	// same query as UKismetSystemLibrary::LineTraceSingle with TraceTypeQuery1 and simple tracing, without its per call allocations
+	const FCollisionQueryParams traceParams(SCENE_QUERY_STAT(CoverGenerationTrace), false);
+	const ECollisionChannel traceChannel = UEngineTypes::ConvertToCollisionChannel(ETraceTypeQuery::TraceTypeQuery1);
+
+	ParallelFor(numTraces, [&](int32 traceIdx)
+	{
+		FHitResult hit;
+		FCoverRaycastHit& outHit = outHits[traceIdx];
+		outHit._blockingHit = _world->LineTraceSingleByChannel(hit, starts[traceIdx], ends[traceIdx], traceChannel, traceParams);
+		outHit._location = hit.Location;
+		outHit._normal = hit.Normal;
+		outHit._impactNormal = hit.ImpactNormal;
+		outHit._distance = hit.Distance;
+		outHit._actor = hit.Actor;
+	}, !_parallel || numTraces < MinParallelBatchSize);
+}
+
+void FCoverWorldRaycaster::CountHits(const TArray<FVector>& starts, const TArray<FVector>& ends, int32 maxCount, TArray<int32>& outNumHits)
+{
+	const int32 numTraces = starts.Num();
+	ParallelFor(numTraces, [&](int32 traceIdx)
+	{
+		outNumHits[traceIdx] = CountHits(_world, starts[traceIdx], ends[traceIdx], maxCount);
+	}, !_parallel || numTraces < MinParallelBatchSize);
+}
+
+int32 FCoverWorldRaycaster::CountHits(UWorld* world, const FVector& start, const FVector& end, int32 maxCount)
+{
+	// distance the next trace starts behind a hit without a component, which can not be ignored
+	const float stepOverDistance = 1.0f;
+
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(CoverCountTrace), false);
+	const ECollisionChannel traceChannel = UEngineTypes::ConvertToCollisionChannel(ETraceTypeQuery::TraceTypeQuery1);
+	const FVector traceDir = (end - start).GetSafeNormal();
+
+	FVector traceStart = start;
+	int32 numHits = 0;
+	FHitResult hit;
+	while (numHits <= maxCount && world->LineTraceSingleByChannel(hit, traceStart, end, traceChannel, traceParams))
+	{
+		numHits++;
+
+		// A trace that starts inside a simple collision shape reports an overlap with it right at the start, so the next trace would hit the
+		// same obstacle again. The component that was hit is ignored by the following traces instead.
+		if (UPrimitiveComponent* component = hit.Component.Get())
+		{
+			traceParams.AddIgnoredComponent(component);
+			traceStart = hit.Location;
+		}
+		else
+		{
+			traceStart = hit.Location + traceDir * stepOverDistance;
+		}
+		if (FVector::DotProduct(end - traceStart, traceDir) <= 0.0f) break;
+	}
+
+	return numHits;
+}
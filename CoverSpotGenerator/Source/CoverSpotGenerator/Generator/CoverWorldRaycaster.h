@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CoverRaycaster.h"
+
+class UWorld;
+
+// Traces against the world's simple collision on the visibility channel, either on the calling thread or spread over worker threads.
+class COVERSPOTGENERATOR_API FCoverWorldRaycaster : public ICoverRaycaster
+{
+public:
+	// below this number of traces, spreading a batch over worker threads costs more than it saves
+	static const int32 MinParallelBatchSize = 32;
+
+	FCoverWorldRaycaster(UWorld* world, bool parallel) : _world(world), _parallel(parallel) { }
+
+	virtual void Raycast(const TArray<FVector>& starts, const TArray<FVector>& ends, TArray<FCoverRaycastHit>& outHits) override;
+	virtual void CountHits(const TArray<FVector>& starts, const TArray<FVector>& ends, int32 maxCount, TArray<int32>& outNumHits) override;
+
+	// Number of blocking components between start and end, found with another single trace from every hit that ignores the components
+	// hit so far. Stops as soon as maxCount is exceeded and then returns maxCount + 1.
+	static int32 CountHits(UWorld* world, const FVector& start, const FVector& end, int32 maxCount);
+
+private:
+	UWorld* _world;
+	bool _parallel;
+};